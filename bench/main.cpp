@@ -0,0 +1,438 @@
+#include <System.h>
+#include <EntityManager.h>
+#include <SpatialHash.h>
+#include <ParticleSystem.h>
+#include <CommandBuffer.h>
+#include <JobSystem.h>
+#include <SoundManager.h>
+#include <Snapshot.h>
+#include <Loader.h>
+#include <Component.h>
+#include <Random.h>
+#include <Util.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Microbenchmarks for the hot loops, each system is timed on its own over
+// worlds of increasing size. Worlds are rebuilt between batches, outside of
+// the timed region, so systems that destroy or spawn entities keep being
+// measured at roughly the requested scale.
+//
+// The vectorised physics integrators are also checked against the scalar
+// one, the exit code is non-zero if any of them differs in a single bit.
+//
+// Usage: AstralindaBench [--scales 10,100,1000,10000,100000] [--filter TEXT]
+//                        [--min-time SECONDS] [--seed S] [--threads N]
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr f32 TICK_DT = 1.0f / 120.0f;
+    // Iterations between world rebuilds
+    constexpr u32 BATCH_ITERATIONS = 8;
+
+    struct BenchOptions
+    {
+        std::vector<u32> scales { 10, 100, 1000, 10000, 100000 };
+        std::string filter {};
+        f64 min_time { 0.1 };
+        u64 seed { 1 };
+        // Worker threads the systems may split their work over, 0 picks one
+        // less than the hardware threads
+        u32 threads { 0 };
+    };
+
+    BenchOptions parse_options(int argc, char** argv)
+    {
+        BenchOptions options {};
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            std::string name = argv[i];
+            std::string value = argv[i + 1];
+
+            if (name == "--scales")
+            {
+                options.scales.clear();
+                std::stringstream stream(value);
+                std::string scale;
+                while (std::getline(stream, scale, ',')) options.scales.push_back(std::stoul(scale));
+            }
+            else if (name == "--filter")   options.filter = value;
+            else if (name == "--min-time") options.min_time = std::stod(value);
+            else if (name == "--seed")     options.seed = std::stoull(value);
+            else if (name == "--threads")  options.threads = std::stoul(value);
+            else std::cerr << "Unknown option '" << name << "'\n";
+        }
+        return options;
+    }
+
+    bool load_headless_textures(Assets& assets)
+    {
+        const std::pair<Texture2D*, const char*> textures[] = {
+            { &assets.ships, "assets/ships.png" },
+            { &assets.stars, "assets/stars.png" },
+            { &assets.effects, "assets/effects.png" },
+            { &assets.projectiles, "assets/projectiles.png" },
+            { &assets.pickups, "assets/pickups.png" },
+        };
+
+        for (auto& [texture, file] : textures)
+        {
+            auto handle = Loader::load_texture_handle(file);
+            if (!handle.has_value())
+            {
+                std::cerr << "Unable to load '" << file << "'\n";
+                return false;
+            }
+            *texture = handle.value();
+        }
+        return true;
+    }
+
+    // Everything a system needs, populated with `scale` enemies, projectiles,
+    // pickups and particles spread over an arena that grows with the
+    // scale so density stays about the same.
+    struct World
+    {
+        World(Assets& assets, SoundManager& sound_manager, JobSystem& jobs, u32 scale)
+            : entity_manager(scale)
+            , particles(assets.effects, scale)
+            , jobs(jobs)
+            , assets(assets)
+            , sound_manager(sound_manager)
+            , circle_radius(400.0f * std::sqrt(static_cast<f32>(scale)))
+        {
+            auto random_pos = [&]() {
+                return Util::get_polar_coordinates(Util::random_f32(0.0f, 2.0f * PI),
+                                                   Util::random_f32(0.0f, circle_radius));
+            };
+
+            player = entity_manager.create_player(assets.ships, 0.0f, 0.0f, 0.0f);
+
+            std::vector<Entity> enemies;
+            enemies.reserve(scale);
+            for (u32 i = 0; i < scale; ++i)
+            {
+                const Vector2 pos = random_pos();
+                const auto type = static_cast<EnemyType>(Util::random_u32(0, 3));
+                enemies.push_back(entity_manager.create_enemy_ship(assets.ships, type, pos.x, pos.y, Util::random_f32(0.0f, 2.0f * PI)));
+            }
+
+            for (u32 i = 0; i < scale; ++i)
+            {
+                const Vector2 pos = random_pos();
+                const auto type = static_cast<ProjectileType>(Util::random_u32(0, 3));
+                const Entity owner = i % 2 == 0 ? player : enemies[i];
+                entity_manager.create_projectile(assets.projectiles, type, owner, pos.x, pos.y, Util::random_f32(0.0f, 2.0f * PI));
+            }
+
+            for (u32 i = 0; i < scale; ++i)
+            {
+                const Vector2 pos = random_pos();
+                entity_manager.create_pickup(assets.pickups, static_cast<PickupType>(Util::random_u32(0, 6)), pos.x, pos.y);
+                particles.emit(static_cast<EffectType>(Util::random_u32(0, 2)), pos.x, pos.y, Util::random_f32(1.0f, 4.0f));
+            }
+        }
+
+        SystemContext context()
+        {
+            return SystemContext {
+                player,
+                entity_manager,
+                sound_manager,
+                broadphase,
+                enemy_index,
+                particles,
+                integrator,
+                jobs,
+                commands,
+                assets,
+                circle_radius,
+                circle_radius * 2.0f,
+                game_over,
+                state
+            };
+        }
+
+        EntityManager entity_manager;
+        SpatialHash broadphase {};
+        SpatialHash enemy_index {};
+        ParticleSystem particles;
+        PhysicsIntegrator integrator {};
+        CommandBuffer commands {};
+        JobSystem& jobs;
+        Assets& assets;
+        SoundManager& sound_manager;
+        Entity player {};
+        f32 circle_radius;
+        bool game_over { false };
+        SystemState state {};
+    };
+
+    struct Benchmark
+    {
+        const char* name;
+        void (*system)(SystemContext&, f32);
+        // Collision systems read the broadphase, it is rebuilt untimed before each iteration
+        bool needs_broadphase { false };
+        // Same for the enemy index and homing projectiles
+        bool needs_enemy_index { false };
+    };
+
+    struct Result
+    {
+        u64 iterations { 0 };
+        f64 total_ns { 0.0 };
+    };
+
+    Result run_system(const Benchmark& benchmark, Assets& assets, SoundManager& sound_manager, JobSystem& jobs, u32 scale, f64 min_time)
+    {
+        Result result {};
+        while (result.total_ns < min_time * 1e9)
+        {
+            World world(assets, sound_manager, jobs, scale);
+            auto context = world.context();
+
+            // Untimed first run, so scratch buffers a system keeps around
+            // are allocated like they would be after the first tick
+            if (benchmark.needs_broadphase) System::update_broadphase(context, TICK_DT);
+            if (benchmark.needs_enemy_index) System::update_enemy_index(context, TICK_DT);
+            benchmark.system(context, TICK_DT);
+            world.commands.flush(world.entity_manager);
+            jobs.reset_scratch();
+
+            for (u32 i = 0; i < BATCH_ITERATIONS && result.total_ns < min_time * 1e9; ++i)
+            {
+                if (benchmark.needs_broadphase) System::update_broadphase(context, TICK_DT);
+                if (benchmark.needs_enemy_index) System::update_enemy_index(context, TICK_DT);
+
+                const auto start = Clock::now();
+                benchmark.system(context, TICK_DT);
+                const auto end = Clock::now();
+
+                result.total_ns += std::chrono::duration<f64, std::nano>(end - start).count();
+                ++result.iterations;
+
+                world.commands.flush(world.entity_manager);
+                jobs.reset_scratch();
+            }
+        }
+        return result;
+    }
+
+    // Times `func` over `count` inputs until `min_time` has passed
+    template <typename Func>
+    Result run_loop(u32 count, f64 min_time, Func func)
+    {
+        Result result {};
+        volatile f32 sink = 0.0f;
+        while (result.total_ns < min_time * 1e9)
+        {
+            const auto start = Clock::now();
+            f32 sum = 0.0f;
+            for (u32 i = 0; i < count; ++i) sum += func(i);
+            const auto end = Clock::now();
+
+            sink = sink + sum;
+            result.total_ns += std::chrono::duration<f64, std::nano>(end - start).count();
+            ++result.iterations;
+        }
+        return result;
+    }
+
+    void fill_random_bodies(PhysicsIntegrator& integrator, u32 count)
+    {
+        auto& buffers = integrator.prepare(count);
+        for (u32 i = 0; i < count; ++i)
+        {
+            buffers.pos_x[i] = Util::random_f32(-5000.0f, 5000.0f);
+            buffers.pos_y[i] = Util::random_f32(-5000.0f, 5000.0f);
+            // Some above the velocity cap, some below
+            buffers.vel_x[i] = Util::random_f32(-300.0f, 300.0f);
+            buffers.vel_y[i] = Util::random_f32(-300.0f, 300.0f);
+            buffers.acc_x[i] = Util::random_f32(-50.0f, 50.0f);
+            buffers.acc_y[i] = Util::random_f32(-50.0f, 50.0f);
+            buffers.thrust[i] = Util::random_f32(50.0f, 4000.0f);
+        }
+    }
+
+    bool same_bits(const std::vector<f32>& a, const std::vector<f32>& b, u32 count)
+    {
+        return std::memcmp(a.data(), b.data(), count * sizeof(f32)) == 0;
+    }
+
+    // Steps the same bodies on the scalar path and on backend, false if any
+    // value differs in a single bit
+    bool integrator_matches_scalar(PhysicsIntegrator::Backend backend, u32 count, u64 seed)
+    {
+        PhysicsIntegrator scalar;
+        PhysicsIntegrator vector;
+        scalar.set_backend(PhysicsIntegrator::Backend::SCALAR);
+        vector.set_backend(backend);
+
+        Random::seed(seed);
+        fill_random_bodies(scalar, count);
+        Random::seed(seed);
+        fill_random_bodies(vector, count);
+
+        for (u32 step = 0; step < 120; ++step)
+        {
+            scalar.integrate(TICK_DT);
+            vector.integrate(TICK_DT);
+        }
+
+        const auto& a = scalar.get_buffers();
+        const auto& b = vector.get_buffers();
+        return same_bits(a.pos_x, b.pos_x, count) && same_bits(a.pos_y, b.pos_y, count) &&
+               same_bits(a.vel_x, b.vel_x, count) && same_bits(a.vel_y, b.vel_y, count) &&
+               same_bits(a.acc_x, b.acc_x, count) && same_bits(a.acc_y, b.acc_y, count);
+    }
+
+    void print_result(const char* name, u32 scale, const Result& result)
+    {
+        const f64 ns_per_iteration = result.total_ns / static_cast<f64>(result.iterations);
+        std::printf("%s,%u,%llu,%.1f,%.2f\n",
+                    name,
+                    scale,
+                    static_cast<unsigned long long>(result.iterations),
+                    ns_per_iteration,
+                    ns_per_iteration / static_cast<f64>(scale));
+        // Large scales take a while, show results as they come
+        std::fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const BenchOptions options = parse_options(argc, argv);
+
+    Assets assets {};
+    if (!load_headless_textures(assets))
+    {
+        return 1;
+    }
+    SoundManager sound_manager(assets);
+    JobSystem jobs(options.threads);
+
+    const Benchmark benchmarks[] = {
+        { "update_enemies", System::update_enemies },
+        { "update_physics", System::update_physics },
+        { "update_projectiles", System::update_projectiles, false, true },
+        { "update_effects", System::update_effects },
+        { "update_pickups", System::update_pickups },
+        { "update_health_circle_radius", System::update_health_circle_radius },
+        { "update_broadphase", System::update_broadphase },
+        { "update_enemy_index", System::update_enemy_index },
+        { "update_projectile_collisions", System::update_projectile_collisions, true },
+        { "update_player_enemy_collisions", System::update_player_enemy_collisions, true },
+        { "update_player_pickup_collisions", System::update_player_pickup_collisions, true },
+    };
+
+    auto selected = [&](const char* name) {
+        return options.filter.empty() || std::string(name).find(options.filter) != std::string::npos;
+    };
+
+    // Vector integrators that don't match the scalar one bit for bit
+    u32 mismatches = 0;
+
+    std::printf("benchmark,scale,iterations,ns_per_iteration,ns_per_entity\n");
+    for (auto scale : options.scales)
+    {
+        if (scale == 0) continue;
+
+        for (const auto& benchmark : benchmarks)
+        {
+            if (!selected(benchmark.name)) continue;
+
+            Random::seed(options.seed);
+            print_result(benchmark.name, scale, run_system(benchmark, assets, sound_manager, jobs, scale, options.min_time));
+        }
+
+        // The integrator on its own, every backend the CPU can run
+        for (auto backend : { PhysicsIntegrator::Backend::SCALAR, PhysicsIntegrator::Backend::SSE, PhysicsIntegrator::Backend::AVX2 })
+        {
+            const std::string name = std::string("integrator_") + PhysicsIntegrator::backend_name(backend);
+            if (!selected(name.c_str()) || !PhysicsIntegrator::is_supported(backend)) continue;
+
+            if (!integrator_matches_scalar(backend, scale, options.seed))
+            {
+                std::cerr << name << " differs from the scalar integrator at scale " << scale << "\n";
+                mismatches += 1;
+            }
+
+            PhysicsIntegrator integrator;
+            integrator.set_backend(backend);
+            Random::seed(options.seed);
+            fill_random_bodies(integrator, scale);
+            print_result(name.c_str(), scale, run_loop(1, options.min_time, [&](u32) {
+                integrator.integrate(TICK_DT);
+                return integrator.get_buffers().pos_x[0];
+            }));
+        }
+
+        // Registry snapshots of a whole world, loaded back into the same one
+        if (selected("snapshot_save") || selected("snapshot_load"))
+        {
+            Random::seed(options.seed);
+            World world(assets, sound_manager, jobs, scale);
+            std::vector<std::byte> bytes;
+
+            print_result("snapshot_save", scale, run_loop(1, options.min_time, [&](u32) {
+                bytes.clear();
+                SnapshotWriter writer(bytes, assets);
+                Snapshot::save_registry(world.entity_manager, writer);
+                return static_cast<f32>(bytes.size());
+            }));
+            print_result("snapshot_load", scale, run_loop(1, options.min_time, [&](u32) {
+                SnapshotReader reader(bytes.data(), bytes.size(), assets, world.entity_manager.registry);
+                return Snapshot::load_registry(world.entity_manager, reader) ? 1.0f : 0.0f;
+            }));
+        }
+
+        // Util math over precomputed random points
+        Random::seed(options.seed);
+        std::vector<Vector2> points(scale);
+        std::vector<f32> angles(scale);
+        for (u32 i = 0; i < scale; ++i)
+        {
+            points[i] = { Util::random_f32(-1000.0f, 1000.0f), Util::random_f32(-1000.0f, 1000.0f) };
+            angles[i] = Util::random_f32(0.0f, 2.0f * PI);
+        }
+
+        if (selected("util_distance_between_points"))
+        {
+            print_result("util_distance_between_points", scale, run_loop(scale, options.min_time, [&](u32 i) {
+                return Util::distance_between_points(points[i], points[scale - 1 - i]);
+            }));
+        }
+        if (selected("util_get_angle_between_points"))
+        {
+            print_result("util_get_angle_between_points", scale, run_loop(scale, options.min_time, [&](u32 i) {
+                return Util::get_angle_between_points(points[i], points[scale - 1 - i]);
+            }));
+        }
+        if (selected("util_get_polar_coordinates"))
+        {
+            print_result("util_get_polar_coordinates", scale, run_loop(scale, options.min_time, [&](u32 i) {
+                const Vector2 pos = Util::get_polar_coordinates(angles[i], 100.0f);
+                return pos.x + pos.y;
+            }));
+        }
+        if (selected("util_lerp"))
+        {
+            print_result("util_lerp", scale, run_loop(scale, options.min_time, [&](u32 i) {
+                return Util::lerp(points[i].x, points[i].y, angles[i]);
+            }));
+        }
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
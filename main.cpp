@@ -1,13 +1,40 @@
 #include <Game.h>
+#include <iostream>
 #include <memory>
+#include <string>
 
-int main()
+// Usage: Astralinda [--seed S] [--record FILE] [--replay FILE] [--resume FILE]
+//                   [--rewind-budget MB] [--render direct|offscreen]
+//                   [--resolution-scale MIN,MAX] [--target-fps FPS]
+int main(int argc, char** argv)
 {
     GameSpecification game_spec{};
     game_spec.width = 2048;
     game_spec.height = 2048;
     game_spec.resizable_window = true;
 
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string name = argv[i];
+        std::string value = argv[i + 1];
+
+        if      (name == "--seed")   game_spec.seed = std::stoull(value);
+        else if (name == "--record") game_spec.record_file = value;
+        else if (name == "--replay") game_spec.replay_file = value;
+        else if (name == "--resume") game_spec.resume_file = value;
+        else if (name == "--rewind-budget") game_spec.rewind_budget = std::stoull(value) * 1024 * 1024;
+        else if (name == "--render") game_spec.offscreen_world = value == "offscreen";
+        else if (name == "--target-fps") game_spec.target_fps = std::stof(value);
+        else if (name == "--resolution-scale")
+        {
+            // One value fixes the scale
+            const auto comma = value.find(',');
+            game_spec.min_resolution_scale = std::stof(value.substr(0, comma));
+            game_spec.max_resolution_scale = comma == std::string::npos ? game_spec.min_resolution_scale : std::stof(value.substr(comma + 1));
+        }
+        else std::cerr << "Unknown option '" << name << "'\n";
+    }
+
     auto game = std::make_unique<Game>(game_spec);
     game->run();
 
@@ -0,0 +1,386 @@
+#include <Simulation.h>
+#include <SoundManager.h>
+#include <Loader.h>
+#include <Component.h>
+#include <Random.h>
+#include <Util.h>
+#include <Replay.h>
+#include <RewindBuffer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <string>
+
+// Headless runner, steps the simulation with scripted input and no window,
+// audio device or GPU, as fast as the CPU allows.
+//
+// Usage: AstralindaSim [--runs N] [--seed S] [--dt SECONDS] [--max-ticks N]
+//                      [--profile-csv FILE] [--threads N]
+//                      [--record FILE] [--replay FILE] [--rewind MB]
+//                      [--rewind-check TICKS]
+//
+// --replay runs a session recorded by the game or by --record once, with
+// its seed, tick length and input, as fast as possible. --record keeps the
+// first run, which plays back the same in the game. --rewind records every
+// tick into a rewind buffer of that size, to see what it costs.
+// --rewind-check then steps back that many ticks at the end of every run,
+// resumes like the game does and plays the same input again, which has to
+// go exactly like the first time.
+
+namespace
+{
+    struct SimOptions
+    {
+        u32 runs { 100 };
+        u64 seed { 1 };
+        f32 dt { 1.0f / 120.0f };
+        u32 max_ticks { 120 * 60 * 5 };
+        // Per system tick times of the last profiler window, one tick per row
+        std::string profile_csv {};
+        // Worker threads for the systems, 0 picks one less than the hardware threads
+        u32 threads { 0 };
+        std::string record {};
+        std::string replay {};
+        // Rewind buffer budget in megabytes, 0 records nothing
+        u32 rewind { 0 };
+        u32 rewind_check { 0 };
+    };
+
+    SimOptions parse_options(int argc, char** argv)
+    {
+        SimOptions options {};
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            std::string name = argv[i];
+            std::string value = argv[i + 1];
+
+            if      (name == "--runs")      options.runs = std::stoul(value);
+            else if (name == "--seed")      options.seed = std::stoull(value);
+            else if (name == "--dt")        options.dt = std::stof(value);
+            else if (name == "--max-ticks") options.max_ticks = std::stoul(value);
+            else if (name == "--profile-csv") options.profile_csv = value;
+            else if (name == "--threads")   options.threads = std::stoul(value);
+            else if (name == "--record")    options.record = value;
+            else if (name == "--replay")    options.replay = value;
+            else if (name == "--rewind")    options.rewind = std::stoul(value);
+            else if (name == "--rewind-check") options.rewind_check = std::stoul(value);
+            else std::cerr << "Unknown option '" << name << "'\n";
+        }
+        return options;
+    }
+
+    bool load_headless_assets(Assets& assets)
+    {
+        const std::pair<Texture2D*, const char*> textures[] = {
+            { &assets.title, "assets/title.png" },
+            { &assets.ships, "assets/ships.png" },
+            { &assets.stars, "assets/stars.png" },
+            { &assets.effects, "assets/effects.png" },
+            { &assets.projectiles, "assets/projectiles.png" },
+            { &assets.engine, "assets/engine.png" },
+            { &assets.warning, "assets/warning.png" },
+            { &assets.pickups, "assets/pickups.png" },
+        };
+
+        for (auto& [texture, file] : textures)
+        {
+            auto handle = Loader::load_texture_handle(file);
+            if (!handle.has_value())
+            {
+                std::cerr << "Unable to load '" << file << "'\n";
+                return false;
+            }
+            *texture = handle.value();
+        }
+
+        auto levels = Loader::load_levels("assets/levels.json");
+        if (!levels.has_value())
+        {
+            std::cerr << "Unable to load 'assets/levels.json'\n";
+            return false;
+        }
+        assets.levels = levels.value();
+        return true;
+    }
+
+    // Turns towards the closest enemy, shoots when roughly aimed at it and
+    // heads back towards the center when leaving the circle.
+    Input scripted_input(Simulation& simulation)
+    {
+        Input input {};
+
+        auto& transform = simulation.player.get_component<Component::Transform>();
+        Vector2 target { 0.0f, 0.0f };
+
+        f32 center_distance = Util::distance_between_points(transform.pos, { 0.0f, 0.0f });
+        if (center_distance < simulation.circle_radius * 0.8f)
+        {
+            f32 shortest_distance = 99999.0f;
+            auto view = simulation.entity_manager.registry.view<Component::Transform, Component::Enemy>();
+            for (auto entity : view)
+            {
+                auto& enemy_transform = view.get<Component::Transform>(entity);
+                f32 distance = Util::distance_between_points(transform.pos, enemy_transform.pos);
+                if (distance < shortest_distance)
+                {
+                    shortest_distance = distance;
+                    target = enemy_transform.pos;
+                }
+            }
+        }
+
+        f32 rotation_diff = Util::get_angle_between_points(transform.pos, target) - transform.rotation;
+        if (rotation_diff > PI) rotation_diff -= 2 * PI;
+        else if (rotation_diff < -PI) rotation_diff += 2 * PI;
+
+        if (rotation_diff > 0.05f) input.set(InputAction::ROTATE_RIGHT);
+        else if (rotation_diff < -0.05f) input.set(InputAction::ROTATE_LEFT);
+
+        if (std::fabs(rotation_diff) < PI / 4) input.set(InputAction::THRUST);
+        if (std::fabs(rotation_diff) < PI / 16) input.set(InputAction::SHOOT);
+
+        return input;
+    }
+
+    // What a tick left behind: the random generator, the level, every
+    // entity and where everything is. Components with padding only count
+    // by their fields, the padding holds whatever was in memory before.
+    u64 fingerprint(Simulation& simulation)
+    {
+        u64 hash = 14695981039346656037ull;
+        auto add = [&](const void* data, size_t size) {
+            const auto* bytes = static_cast<const u8*>(data);
+            for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+        };
+
+        auto& registry = simulation.entity_manager.registry;
+        add(&Random::engine(), sizeof(Random::engine()));
+        add(&simulation.level_index, sizeof(simulation.level_index));
+        add(&simulation.circle_radius, sizeof(simulation.circle_radius));
+        add(&simulation.bonus_timer, sizeof(simulation.bonus_timer));
+        add(&simulation.game_over, sizeof(simulation.game_over));
+        add(&simulation.game_won, sizeof(simulation.game_won));
+        add(&simulation.player.get_component<Component::Player>().score, sizeof(u32));
+
+        const auto& entities = registry.storage<entt::entity>();
+        const auto in_use = entities.in_use();
+        add(entities.data(), entities.size() * sizeof(entt::entity));
+        add(&in_use, sizeof(in_use));
+
+        for (auto [entity, transform] : registry.storage<Component::Transform>().each())
+        {
+            add(&entity, sizeof(entity));
+            add(&transform, sizeof(transform));
+        }
+        for (auto [entity, physics] : registry.storage<Component::Physics>().each())
+        {
+            add(&entity, sizeof(entity));
+            add(&physics, sizeof(physics));
+        }
+        for (auto [entity, health] : registry.storage<Component::Health>().each())
+        {
+            add(&entity, sizeof(entity));
+            add(&health.shield, sizeof(health.shield));
+            add(&health.health, sizeof(health.health));
+        }
+        return hash;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    SimOptions options = parse_options(argc, argv);
+
+    Replay recording {};
+    recording.seed = options.seed;
+    recording.tick_dt = options.dt;
+
+    std::optional<Replay> replay;
+    if (!options.replay.empty())
+    {
+        replay = Replay::read(options.replay);
+        if (!replay.has_value())
+        {
+            std::cerr << "Unable to load replay '" << options.replay << "'\n";
+            return 1;
+        }
+        options.runs = 1;
+        options.seed = replay->seed;
+        options.dt = replay->tick_dt;
+        options.max_ticks = replay->get_tick_count();
+    }
+
+    Random::seed(options.seed);
+
+    Assets assets {};
+    if (!load_headless_assets(assets))
+    {
+        return 1;
+    }
+
+    auto backend = std::make_unique<NullAudioBackend>();
+    auto& audio = *backend;
+    SoundManager sound_manager(assets, std::move(backend));
+    Simulation simulation(assets, sound_manager, options.threads);
+    RewindBuffer rewind(static_cast<size_t>(options.rewind) * 1024 * 1024);
+
+    u32 won = 0;
+    u32 lost = 0;
+    u64 total_ticks = 0;
+    u32 rewind_mismatches = 0;
+
+    auto step = [&](const Input& input)
+    {
+        simulation.profiler.begin_frame();
+        simulation.update(options.dt, input);
+        if (options.rewind > 0)
+        {
+            ProfileScope scope(simulation.profiler, "rewind_record");
+            rewind.record(simulation);
+        }
+        sound_manager.flush();
+        // Nothing is heard, voices are done by the next tick
+        audio.finish_all();
+        simulation.profiler.end_frame();
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::printf("run,level,outcome,ticks,score\n");
+    for (u32 run = 0; run < options.runs; ++run)
+    {
+        simulation.level_index = run % static_cast<u32>(assets.levels.size());
+        simulation.setup_level(simulation.level_index);
+
+        // A replay goes on through level changes, until its input runs out
+        u32 ticks = 0;
+        Replay played {};
+        std::vector<u64> fingerprints {};
+        while (ticks < options.max_ticks && (replay.has_value() || !simulation.level_finished()))
+        {
+            Input input {};
+            if (replay.has_value())
+            {
+                const auto death_distance = replay->get_death_distance(ticks);
+                if (death_distance.has_value()) simulation.death_distance = death_distance.value();
+                input = replay->get_input(ticks);
+            }
+            else
+            {
+                input = scripted_input(simulation);
+                if (run == 0 && !options.record.empty()) recording.record(input, simulation.death_distance);
+            }
+            if (options.rewind_check > 0) played.record(input, simulation.death_distance);
+
+            step(input);
+            if (options.rewind_check > 0) fingerprints.push_back(fingerprint(simulation));
+            ++ticks;
+        }
+        total_ticks += ticks;
+
+        const char* outcome = "timeout";
+        if (simulation.game_over)
+        {
+            outcome = "lost";
+            ++lost;
+        }
+        else if (simulation.level_finished())
+        {
+            outcome = "won";
+            ++won;
+        }
+
+        std::printf("%u,%u,%s,%u,%u\n",
+                    run,
+                    simulation.level_index + 1,
+                    outcome,
+                    ticks,
+                    simulation.player.get_component<Component::Player>().score);
+
+        if (options.rewind > 0 && options.rewind_check > 0 && ticks > 0)
+        {
+            // No further back than this run's first tick
+            const u32 frames = rewind.get_tick_count();
+            const u32 steps = std::min(options.rewind_check, ticks - 1);
+            for (u32 i = 0; i < steps && rewind.step_back(simulation); ++i) {}
+            rewind.resume(simulation);
+
+            // The newest frame is the world after the last tick played
+            const u32 resumed = frames - rewind.get_tick_count();
+            u32 first_different = ticks;
+            if (fingerprint(simulation) != fingerprints[ticks - resumed - 1]) first_different = ticks - resumed - 1;
+            for (u32 tick = ticks - resumed; tick < ticks; ++tick)
+            {
+                const auto death_distance = played.get_death_distance(tick);
+                if (death_distance.has_value()) simulation.death_distance = death_distance.value();
+                step(played.get_input(tick));
+                if (first_different == ticks && fingerprint(simulation) != fingerprints[tick]) first_different = tick;
+            }
+
+            if (first_different == ticks)
+            {
+                std::fprintf(stderr, "run %u: resumed %u ticks back, went the same\n", run, resumed);
+            }
+            else
+            {
+                std::fprintf(stderr, "run %u: resumed %u ticks back, went differently from tick %u\n", run, resumed, first_different);
+                ++rewind_mismatches;
+            }
+        }
+    }
+
+    const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%u runs (%u won, %u lost) in %.3f s, %llu ticks, %.0f ticks/s\n",
+                 options.runs, won, lost, seconds,
+                 static_cast<unsigned long long>(total_ticks),
+                 static_cast<f64>(total_ticks) / seconds);
+
+    const auto pool = simulation.entity_manager.get_projectile_pool_stats();
+    std::fprintf(stderr, "projectile pool: %u active, %u inactive, %u peak active, %u reserved\n",
+                 pool.active, pool.inactive, pool.peak_active, pool.reserved);
+
+    if (options.rewind > 0)
+    {
+        std::fprintf(stderr, "rewind: %u ticks (%.1f s) in %.1f MB\n",
+                     rewind.get_tick_count(),
+                     static_cast<f64>(rewind.get_tick_count()) * options.dt,
+                     static_cast<f64>(rewind.get_memory_used()) / (1024.0 * 1024.0));
+    }
+    if (rewind_mismatches > 0)
+    {
+        std::fprintf(stderr, "rewind check: %u runs went differently after resuming\n", rewind_mismatches);
+    }
+
+    if (!options.record.empty() && !recording.write(options.record))
+    {
+        std::cerr << "Unable to write '" << options.record << "'\n";
+    }
+
+    const auto& sounds = sound_manager.get_stats();
+    std::fprintf(stderr, "sounds: %llu requested, %llu culled, %llu merged, %llu played, %llu stolen, %llu dropped\n",
+                 static_cast<unsigned long long>(sounds.requested),
+                 static_cast<unsigned long long>(sounds.culled),
+                 static_cast<unsigned long long>(sounds.merged),
+                 static_cast<unsigned long long>(sounds.played),
+                 static_cast<unsigned long long>(sounds.stolen),
+                 static_cast<unsigned long long>(sounds.dropped));
+
+    if (!options.profile_csv.empty())
+    {
+        for (const auto& section : simulation.profiler.get_stats())
+        {
+            std::fprintf(stderr, "%-32s avg %.4f ms, p99 %.4f ms\n", section.name, section.avg_ms, section.p99_ms);
+        }
+        if (!simulation.profiler.write_csv(options.profile_csv))
+        {
+            std::cerr << "Unable to write '" << options.profile_csv << "'\n";
+            return 1;
+        }
+    }
+
+    return rewind_mismatches > 0 ? 1 : 0;
+}
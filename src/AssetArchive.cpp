@@ -0,0 +1,230 @@
+#include <AssetArchive.h>
+
+#include <cstring>
+#include <fstream>
+
+using namespace ArchiveFormat;
+
+namespace
+{
+    u64 align(u64 offset)
+    {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    template<typename T>
+    void append(std::vector<std::byte>& bytes, const T& value)
+    {
+        const auto* first = reinterpret_cast<const std::byte*>(&value);
+        bytes.insert(bytes.end(), first, first + sizeof(T));
+    }
+}
+
+bool AssetArchive::open(const std::string& path)
+{
+    entries = nullptr;
+    entry_count = 0;
+    if (!file.open(path)) return false;
+
+    const auto* data = file.get_data();
+    const size_t size = file.get_size();
+
+    Header header {};
+    if (size >= sizeof(Header)) std::memcpy(&header, data, sizeof(Header));
+
+    // Everything has to be inside the file, a truncated archive counts as missing
+    bool valid = size >= sizeof(Header)
+            && std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+            && header.version == VERSION
+            && sizeof(Header) + static_cast<u64>(header.entry_count) * sizeof(Entry) <= size;
+
+    const auto* table = reinterpret_cast<const Entry*>(data + sizeof(Header));
+    for (u32 i = 0; valid && i < header.entry_count; ++i)
+    {
+        valid = table[i].offset <= size && table[i].size <= size - table[i].offset;
+    }
+
+    if (!valid)
+    {
+        file.close();
+        return false;
+    }
+
+    entries = table;
+    entry_count = header.entry_count;
+    return true;
+}
+
+const Entry* AssetArchive::find(const std::string& name, Kind kind) const
+{
+    for (u32 i = 0; i < entry_count; ++i)
+    {
+        const auto& entry = entries[i];
+        if (entry.kind == kind && std::strncmp(entry.name, name.c_str(), NAME_LENGTH) == 0) return &entry;
+    }
+    return nullptr;
+}
+
+std::optional<Image> AssetArchive::find_image(const std::string& name) const
+{
+    const auto* entry = find(name, Kind::IMAGE);
+    if (entry == nullptr || entry->size != static_cast<u64>(entry->width) * entry->height * 4) return std::nullopt;
+
+    Image image {};
+    image.data = const_cast<std::byte*>(file.get_data() + entry->offset);
+    image.width = static_cast<int>(entry->width);
+    image.height = static_cast<int>(entry->height);
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return image;
+}
+
+std::optional<Wave> AssetArchive::find_wave(const std::string& name) const
+{
+    const auto* entry = find(name, Kind::WAVE);
+    if (entry == nullptr || entry->size != static_cast<u64>(entry->frame_count) * entry->channels * entry->sample_size / 8) return std::nullopt;
+
+    Wave wave {};
+    wave.data = const_cast<std::byte*>(file.get_data() + entry->offset);
+    wave.frameCount = entry->frame_count;
+    wave.sampleRate = entry->sample_rate;
+    wave.sampleSize = entry->sample_size;
+    wave.channels = entry->channels;
+    return wave;
+}
+
+std::optional<std::vector<Level>> AssetArchive::find_levels(const std::string& name) const
+{
+    const auto* entry = find(name, Kind::LEVELS);
+    if (entry == nullptr || entry->size < sizeof(u32)) return std::nullopt;
+
+    const auto* data = file.get_data() + entry->offset;
+    const auto* end = data + entry->size;
+
+    u32 count = 0;
+    std::memcpy(&count, data, sizeof(u32));
+    data += sizeof(u32);
+
+    std::vector<Level> levels;
+    levels.reserve(count);
+    for (u32 i = 0; i < count; ++i)
+    {
+        LevelRecord record {};
+        if (static_cast<size_t>(end - data) < sizeof(LevelRecord)) return std::nullopt;
+        std::memcpy(&record, data, sizeof(LevelRecord));
+        data += sizeof(LevelRecord);
+
+        if (static_cast<u64>(end - data) < static_cast<u64>(record.name_length) + record.enemy_count) return std::nullopt;
+
+        Level level;
+        level.name.assign(reinterpret_cast<const char*>(data), record.name_length);
+        data += record.name_length;
+        level.enemy_types.resize(record.enemy_count);
+        std::memcpy(level.enemy_types.data(), data, record.enemy_count);
+        data += record.enemy_count;
+
+        level.bonus_score = record.bonus_score;
+        level.bonus_time_seconds = record.bonus_time_seconds;
+        level.circle_radius = record.circle_radius;
+        levels.push_back(std::move(level));
+    }
+
+    return levels;
+}
+
+bool AssetArchiveWriter::add(const std::string& name, Entry entry, const void* data, size_t size)
+{
+    if (name.size() >= NAME_LENGTH) return false;
+
+    std::strncpy(entry.name, name.c_str(), NAME_LENGTH);
+    entry.size = size;
+    entries.push_back(entry);
+
+    const auto* first = static_cast<const std::byte*>(data);
+    payloads.emplace_back(first, first + size);
+    return true;
+}
+
+bool AssetArchiveWriter::add_image(const std::string& name, const Image& image)
+{
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || image.data == nullptr) return false;
+
+    Entry entry {};
+    entry.kind = Kind::IMAGE;
+    entry.width = static_cast<u32>(image.width);
+    entry.height = static_cast<u32>(image.height);
+    return add(name, entry, image.data, static_cast<size_t>(image.width) * image.height * 4);
+}
+
+bool AssetArchiveWriter::add_wave(const std::string& name, const Wave& wave)
+{
+    if (wave.data == nullptr) return false;
+
+    Entry entry {};
+    entry.kind = Kind::WAVE;
+    entry.frame_count = wave.frameCount;
+    entry.sample_rate = wave.sampleRate;
+    entry.sample_size = static_cast<u16>(wave.sampleSize);
+    entry.channels = static_cast<u16>(wave.channels);
+    return add(name, entry, wave.data, static_cast<size_t>(wave.frameCount) * wave.channels * wave.sampleSize / 8);
+}
+
+bool AssetArchiveWriter::add_levels(const std::string& name, const std::vector<Level>& levels)
+{
+    std::vector<std::byte> bytes;
+    append(bytes, static_cast<u32>(levels.size()));
+    for (const auto& level : levels)
+    {
+        const LevelRecord record {
+            level.bonus_score,
+            level.bonus_time_seconds,
+            level.circle_radius,
+            static_cast<u32>(level.name.size()),
+            static_cast<u32>(level.enemy_types.size())
+        };
+        append(bytes, record);
+
+        const auto* name_bytes = reinterpret_cast<const std::byte*>(level.name.data());
+        bytes.insert(bytes.end(), name_bytes, name_bytes + level.name.size());
+        const auto* enemy_bytes = reinterpret_cast<const std::byte*>(level.enemy_types.data());
+        bytes.insert(bytes.end(), enemy_bytes, enemy_bytes + level.enemy_types.size());
+    }
+
+    Entry entry {};
+    entry.kind = Kind::LEVELS;
+    return add(name, entry, bytes.data(), bytes.size());
+}
+
+bool AssetArchiveWriter::write(const std::string& file) const
+{
+    Header header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.entry_count = static_cast<u32>(entries.size());
+
+    // Offsets are only known once everything is in
+    std::vector<Entry> table = entries;
+    u64 offset = align(sizeof(Header) + table.size() * sizeof(Entry));
+    for (auto& entry : table)
+    {
+        entry.offset = offset;
+        offset = align(offset + entry.size);
+    }
+
+    std::ofstream output(file, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) return false;
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    output.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(Entry)));
+
+    const char padding[ALIGNMENT] {};
+    u64 written = sizeof(Header) + table.size() * sizeof(Entry);
+    for (u32 i = 0; i < table.size(); ++i)
+    {
+        output.write(padding, static_cast<std::streamsize>(table[i].offset - written));
+        output.write(reinterpret_cast<const char*>(payloads[i].data()), static_cast<std::streamsize>(payloads[i].size()));
+        written = table[i].offset + payloads[i].size();
+    }
+
+    return static_cast<bool>(output);
+}
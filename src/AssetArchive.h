@@ -0,0 +1,108 @@
+#pragma once
+
+#include <types.h>
+#include <Level.h>
+#include <MappedFile.h>
+
+#include <raylib.h>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Assets packed into one file at build time by AstralindaPack. Textures are
+// stored as raw RGBA8 texels, sounds as decoded PCM and levels as a compiled
+// table, so nothing has to be decoded at startup.
+//
+// Layout, little endian: the header, the entry table, then every payload
+// aligned to ALIGNMENT bytes from the start of the file.
+namespace ArchiveFormat
+{
+    constexpr char MAGIC[8] = { 'A', 'S', 'T', 'R', 'P', 'A', 'K', '\0' };
+    constexpr u32 VERSION = 1;
+    constexpr u32 ALIGNMENT = 64;
+    constexpr u32 NAME_LENGTH = 48;
+
+    enum class Kind : u32
+    {
+        IMAGE = 0,
+        WAVE,
+        LEVELS
+    };
+
+    struct Header
+    {
+        char magic[8];
+        u32 version;
+        u32 entry_count;
+    };
+
+    struct Entry
+    {
+        // Path the asset was packed from, e.g. "assets/ships.png"
+        char name[NAME_LENGTH];
+        Kind kind;
+        // Images
+        u32 width;
+        u32 height;
+        // Waves
+        u32 frame_count;
+        u32 sample_rate;
+        u16 sample_size;
+        u16 channels;
+        u64 offset;
+        u64 size;
+    };
+
+    // A levels payload is a u32 count and that many records, each followed
+    // by its name and one u8 per enemy
+    struct LevelRecord
+    {
+        u32 bonus_score;
+        u32 bonus_time_seconds;
+        u32 circle_radius;
+        u32 name_length;
+        u32 enemy_count;
+    };
+}
+
+// Maps an archive and hands out images and waves pointing straight into it,
+// they stay valid as long as the archive is open and must not be unloaded.
+class AssetArchive
+{
+public:
+    // False if the file is missing or isn't a valid archive
+    bool open(const std::string& file);
+
+    [[nodiscard]] bool is_open() const { return file.is_open(); }
+
+    [[nodiscard]] std::optional<Image> find_image(const std::string& name) const;
+    [[nodiscard]] std::optional<Wave> find_wave(const std::string& name) const;
+    // Levels are small, they're copied out
+    [[nodiscard]] std::optional<std::vector<Level>> find_levels(const std::string& name) const;
+
+private:
+    [[nodiscard]] const ArchiveFormat::Entry* find(const std::string& name, ArchiveFormat::Kind kind) const;
+
+    MappedFile file {};
+    const ArchiveFormat::Entry* entries { nullptr };
+    u32 entry_count { 0 };
+};
+
+// Builds an archive in memory, used by the packer
+class AssetArchiveWriter
+{
+public:
+    // Images have to be RGBA8 already
+    bool add_image(const std::string& name, const Image& image);
+    bool add_wave(const std::string& name, const Wave& wave);
+    bool add_levels(const std::string& name, const std::vector<Level>& levels);
+
+    bool write(const std::string& file) const;
+
+private:
+    bool add(const std::string& name, ArchiveFormat::Entry entry, const void* data, size_t size);
+
+    std::vector<ArchiveFormat::Entry> entries {};
+    std::vector<std::vector<std::byte>> payloads {};
+};
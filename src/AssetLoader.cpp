@@ -0,0 +1,191 @@
+#include <AssetLoader.h>
+#include <Loader.h>
+
+#include <algorithm>
+#include <cassert>
+
+AssetLoader::AssetLoader(JobSystem& jobs)
+    : jobs(jobs)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+    jobs.wait(counter);
+
+    // Sheet images and whatever didn't make it to the GPU
+    for (auto& request : requests)
+    {
+        if (request.mapped) continue;
+        if (request.image.data != nullptr) UnloadImage(request.image);
+        if (request.wave.data != nullptr) UnloadWave(request.wave);
+    }
+}
+
+bool AssetLoader::open_archive(const std::string& file)
+{
+    assert(!started);
+    return archive.open(file);
+}
+
+void AssetLoader::add_texture(Texture2D& texture, const char* file, bool sheet)
+{
+    assert(!started);
+    requests.emplace_back().kind = sheet ? Kind::SHEET : Kind::TEXTURE;
+    requests.back().file = file;
+    requests.back().target = &texture;
+}
+
+void AssetLoader::add_sound(Sound& sound, const char* file)
+{
+    assert(!started);
+
+    // Opening the device takes a while as well, it goes along with the files
+    if (!std::any_of(requests.begin(), requests.end(), [](const Request& request) { return request.kind == Kind::AUDIO_DEVICE; }))
+    {
+        requests.emplace_back().kind = Kind::AUDIO_DEVICE;
+        requests.back().file = "audio device";
+        requests.back().target = nullptr;
+    }
+
+    requests.emplace_back().kind = Kind::SOUND;
+    requests.back().file = file;
+    requests.back().target = &sound;
+}
+
+void AssetLoader::add_levels(std::vector<Level>& levels, const char* file)
+{
+    assert(!started);
+    requests.emplace_back().kind = Kind::LEVELS;
+    requests.back().file = file;
+    requests.back().target = &levels;
+}
+
+void AssetLoader::start()
+{
+    started = true;
+
+    // Idle workers take the oldest jobs first, so things come in roughly in the order they were added
+    for (auto& request : requests)
+    {
+        if (resolve(request)) request.decoded.store(true, std::memory_order_relaxed);
+        else jobs.submit(counter, decode, &request);
+    }
+}
+
+bool AssetLoader::resolve(Request& request) const
+{
+    if (!archive.is_open()) return false;
+
+    switch (request.kind)
+    {
+        case Kind::TEXTURE:
+        case Kind::SHEET:
+        {
+            const auto image = archive.find_image(request.file);
+            if (!image.has_value()) return false;
+            request.image = image.value();
+            request.mapped = true;
+            return true;
+        }
+        case Kind::SOUND:
+        {
+            const auto wave = archive.find_wave(request.file);
+            if (!wave.has_value()) return false;
+            request.wave = wave.value();
+            request.mapped = true;
+            return true;
+        }
+        case Kind::LEVELS:
+            request.levels = archive.find_levels(request.file);
+            return request.levels.has_value();
+        case Kind::AUDIO_DEVICE:
+            break;
+    }
+    return false;
+}
+
+void AssetLoader::decode(void* data, u32, u32)
+{
+    auto& request = *static_cast<Request*>(data);
+
+    switch (request.kind)
+    {
+        case Kind::TEXTURE:
+        case Kind::SHEET:
+            request.image = LoadImage(request.file);
+            break;
+        case Kind::SOUND:
+            request.wave = LoadWave(request.file);
+            break;
+        case Kind::LEVELS:
+            request.levels = Loader::load_levels(request.file);
+            break;
+        case Kind::AUDIO_DEVICE:
+            InitAudioDevice();
+            break;
+    }
+
+    request.decoded.store(true, std::memory_order_release);
+}
+
+bool AssetLoader::update()
+{
+    // Without workers nobody else runs the jobs, one per frame keeps the screen responsive
+    if (jobs.get_thread_count() == 1) jobs.try_run();
+
+    for (auto& request : requests)
+    {
+        if (request.finished || !request.decoded.load(std::memory_order_acquire)) continue;
+        if (!finish(request)) continue;
+
+        request.finished = true;
+        finished_count += 1;
+    }
+
+    return finished_count == requests.size();
+}
+
+bool AssetLoader::finish(Request& request)
+{
+    switch (request.kind)
+    {
+        case Kind::TEXTURE:
+            *static_cast<Texture2D*>(request.target) = LoadTextureFromImage(request.image);
+            if (!request.mapped) UnloadImage(request.image);
+            request.image = {};
+            break;
+        case Kind::SHEET:
+        {
+            auto& texture = *static_cast<Texture2D*>(request.target);
+            texture = LoadTextureFromImage(request.image);
+            sheets.push_back({ &texture, request.image });
+            break;
+        }
+        case Kind::SOUND:
+        {
+            // Converted to the device's format, so it has to be open
+            if (!audio_ready) return false;
+
+            auto& sound = *static_cast<Sound*>(request.target);
+            sound = LoadSoundFromWave(request.wave);
+            if (!request.mapped) UnloadWave(request.wave);
+            request.wave = {};
+            break;
+        }
+        case Kind::LEVELS:
+            if (request.levels.has_value()) *static_cast<std::vector<Level>*>(request.target) = std::move(request.levels.value());
+            else failed_file = request.file;
+            break;
+        case Kind::AUDIO_DEVICE:
+            audio_ready = true;
+            break;
+    }
+    return true;
+}
+
+f32 AssetLoader::get_progress() const
+{
+    if (requests.empty()) return 1.0f;
+    return static_cast<f32>(finished_count) / static_cast<f32>(requests.size());
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <types.h>
+#include <Level.h>
+#include <JobSystem.h>
+#include <SpriteBatch.h>
+#include <AssetArchive.h>
+
+#include <raylib.h>
+#include <atomic>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Loads assets in the background. Files are read and decoded into CPU
+// memory by jobs, update() turns whatever finished into textures and sounds
+// on the calling thread, which has to be the one owning the window. Every
+// target stays zeroed until its upload happened, so it can be handed out
+// before it's loaded.
+//
+// Assets found in an opened archive skip the decoding, their images and
+// waves point into the mapped file and go straight to the upload. Anything
+// missing from it is loaded from its own file as usual.
+//
+// Everything is added first, start() queues all of it at once.
+class AssetLoader
+{
+public:
+    explicit AssetLoader(JobSystem& jobs);
+    // Waits for jobs that are still decoding
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // False if there is no usable archive, everything comes from the files then
+    bool open_archive(const std::string& file);
+
+    // Sheets keep their image around for the sprite batch's atlas
+    void add_texture(Texture2D& texture, const char* file, bool sheet = false);
+    void add_sound(Sound& sound, const char* file);
+    void add_levels(std::vector<Level>& levels, const char* file);
+    void start();
+
+    // Uploads what has been decoded since the last call, once per frame.
+    // Returns true once everything is in.
+    bool update();
+
+    // Share of the assets that are ready, from 0 to 1
+    [[nodiscard]] f32 get_progress() const;
+    // Set when a file without a fallback couldn't be loaded
+    [[nodiscard]] const char* get_failed_file() const { return failed_file; }
+    // Images of the sheets for the atlas, they go along with the loader
+    [[nodiscard]] const std::vector<SpriteBatch::Sheet>& get_sheets() const { return sheets; }
+
+private:
+    enum class Kind : u8
+    {
+        TEXTURE = 0,
+        SHEET,
+        SOUND,
+        LEVELS,
+        AUDIO_DEVICE
+    };
+
+    struct Request
+    {
+        Kind kind;
+        const char* file;
+        void* target;
+
+        // Written by the job, read after decoded is set
+        Image image {};
+        Wave wave {};
+        std::optional<std::vector<Level>> levels {};
+        std::atomic<bool> decoded { false };
+        // Image or wave lives in the archive, it isn't unloaded
+        bool mapped { false };
+
+        bool finished { false };
+    };
+
+    // Job entry point, data is the request
+    static void decode(void* data, u32, u32);
+    // Looks the request up in the archive instead of decoding it
+    bool resolve(Request& request) const;
+    // Main thread part, false if it has to wait for something else first
+    bool finish(Request& request);
+
+    JobSystem& jobs;
+    JobCounter counter {};
+    AssetArchive archive {};
+    // Requests don't move once added, jobs point into it
+    std::deque<Request> requests {};
+    std::vector<SpriteBatch::Sheet> sheets {};
+
+    u32 finished_count { 0 };
+    bool audio_ready { false };
+    bool started { false };
+    const char* failed_file { nullptr };
+};
@@ -0,0 +1,63 @@
+#include <AudioBackend.h>
+
+std::optional<u32> NullAudioBackend::create_voice(const Sound&)
+{
+    voices.emplace_back();
+    return static_cast<u32>(voices.size() - 1);
+}
+
+void NullAudioBackend::play(u32 voice, f32 volume)
+{
+    voices[voice] = Voice { true, volume };
+    play_count += 1;
+}
+
+void NullAudioBackend::stop(u32 voice)
+{
+    voices[voice].playing = false;
+}
+
+bool NullAudioBackend::is_playing(u32 voice) const
+{
+    return voices[voice].playing;
+}
+
+void NullAudioBackend::finish_all()
+{
+    for (auto& voice : voices) voice.playing = false;
+}
+
+#ifndef ASTRALINDA_HEADLESS
+RaylibAudioBackend::~RaylibAudioBackend()
+{
+    for (const auto& voice : voices) UnloadSoundAlias(voice);
+}
+
+std::optional<u32> RaylibAudioBackend::create_voice(const Sound& source)
+{
+    if (!IsSoundReady(source)) return std::nullopt;
+
+    const Sound alias = LoadSoundAlias(source);
+    if (!IsSoundReady(alias)) return std::nullopt;
+
+    voices.push_back(alias);
+    return static_cast<u32>(voices.size() - 1);
+}
+
+void RaylibAudioBackend::play(u32 voice, f32 volume)
+{
+    // Aliases don't share the volume of their source, it's set on every play
+    SetSoundVolume(voices[voice], volume);
+    PlaySound(voices[voice]);
+}
+
+void RaylibAudioBackend::stop(u32 voice)
+{
+    StopSound(voices[voice]);
+}
+
+bool RaylibAudioBackend::is_playing(u32 voice) const
+{
+    return IsSoundPlaying(voices[voice]);
+}
+#endif
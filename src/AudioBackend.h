@@ -0,0 +1,70 @@
+#pragma once
+
+#include <types.h>
+
+#include <raylib.h>
+#include <optional>
+#include <vector>
+
+// Where SoundManager's voices end up. A voice plays one sound at a time and
+// shares the sample data of the sound it was created from, playing it again
+// restarts it.
+class AudioBackend
+{
+public:
+    virtual ~AudioBackend() = default;
+
+    // Nothing if the source can't be played (yet)
+    virtual std::optional<u32> create_voice(const Sound& source) = 0;
+    virtual void play(u32 voice, f32 volume) = 0;
+    virtual void stop(u32 voice) = 0;
+    [[nodiscard]] virtual bool is_playing(u32 voice) const = 0;
+};
+
+// Plays nothing, voices count as playing until they are stopped or
+// finish_all() is called. For the headless targets and for inspecting what
+// the mixer decided.
+class NullAudioBackend : public AudioBackend
+{
+public:
+    std::optional<u32> create_voice(const Sound& source) override;
+    void play(u32 voice, f32 volume) override;
+    void stop(u32 voice) override;
+    [[nodiscard]] bool is_playing(u32 voice) const override;
+
+    void finish_all();
+
+    [[nodiscard]] u64 get_play_count() const { return play_count; }
+    [[nodiscard]] f32 get_last_volume(u32 voice) const { return voices[voice].volume; }
+
+private:
+    struct Voice
+    {
+        bool playing { false };
+        f32 volume { 0.0f };
+    };
+
+    std::vector<Voice> voices {};
+    u64 play_count { 0 };
+};
+
+#ifndef ASTRALINDA_HEADLESS
+// Voices are raylib sound aliases, they need the audio device
+class RaylibAudioBackend : public AudioBackend
+{
+public:
+    RaylibAudioBackend() = default;
+    ~RaylibAudioBackend() override;
+
+    RaylibAudioBackend(const RaylibAudioBackend&) = delete;
+    RaylibAudioBackend& operator=(const RaylibAudioBackend&) = delete;
+
+    std::optional<u32> create_voice(const Sound& source) override;
+    void play(u32 voice, f32 volume) override;
+    void stop(u32 voice) override;
+    [[nodiscard]] bool is_playing(u32 voice) const override;
+
+private:
+    std::vector<Sound> voices {};
+};
+#endif
@@ -0,0 +1,117 @@
+#include <Background.h>
+#include <Random.h>
+#include <Util.h>
+
+#include <cmath>
+
+namespace
+{
+    // World units per tile, the tiles repeat too far apart to notice
+    constexpr s32 TILE_SIZE = 1024;
+    // Keeps the stars' numbers apart from anything else drawn from the same seed
+    constexpr u64 STAR_STREAM = 0x5354415253ULL;
+
+    struct LayerSpecification
+    {
+        f32 parallax;
+        u32 star_count;
+        f32 min_scale;
+        f32 max_scale;
+        f32 min_brightness;
+        f32 twinkle_speed;
+    };
+
+    // Far to near. About a hundred times the stars the levels used to
+    // spawn as entities, the nearest layer sits still in the world as they did.
+    constexpr LayerSpecification LAYERS[] = {
+        { 0.3f, 300, 0.03f, 0.10f, 0.35f, 0.4f },
+        { 0.6f, 160, 0.06f, 0.16f, 0.45f, 0.7f },
+        { 1.0f, 70, 0.10f, 0.25f, 0.55f, 1.1f },
+    };
+}
+
+Background::Background(const Texture2D& star, u64 seed)
+{
+    Random::Pcg32 random(seed, STAR_STREAM);
+    const f32 star_size = static_cast<f32>(star.width);
+
+    for (const auto& specification : LAYERS)
+    {
+        Layer layer {
+            LoadRenderTexture(TILE_SIZE, TILE_SIZE),
+            specification.parallax,
+            specification.min_brightness,
+            specification.twinkle_speed,
+            random.next_f32() * 2.0f * PI
+        };
+
+        BeginTextureMode(layer.tile);
+        ClearBackground(BLACK);
+        for (u32 i = 0; i < specification.star_count; ++i)
+        {
+            const f32 x = random.next_f32() * TILE_SIZE;
+            const f32 y = random.next_f32() * TILE_SIZE;
+            const f32 size = star_size * Util::lerp(specification.min_scale, specification.max_scale, random.next_f32());
+            const f32 rotation = random.next_f32() * 360.0f;
+
+            // Copies on the other sides, so stars over an edge carry on in the next tile
+            for (s32 dy = -1; dy <= 1; ++dy)
+            {
+                for (s32 dx = -1; dx <= 1; ++dx)
+                {
+                    DrawTexturePro(star,
+                                   { 0.0f, 0.0f, star_size, star_size },
+                                   { x + static_cast<f32>(dx * TILE_SIZE), y + static_cast<f32>(dy * TILE_SIZE), size, size },
+                                   { size / 2, size / 2 },
+                                   rotation,
+                                   WHITE);
+                }
+            }
+        }
+        EndTextureMode();
+
+        // The view shrinks the tiles, mipmaps keep the small stars from flickering
+        GenTextureMipmaps(&layer.tile.texture);
+        SetTextureFilter(layer.tile.texture, TEXTURE_FILTER_TRILINEAR);
+        SetTextureWrap(layer.tile.texture, TEXTURE_WRAP_REPEAT);
+
+        layers.push_back(layer);
+    }
+}
+
+Background::~Background()
+{
+    for (auto& layer : layers)
+    {
+        UnloadRenderTexture(layer.tile);
+    }
+}
+
+void Background::draw(Vector2 center, f32 half_width, f32 half_height, Vector2 camera, f64 time) const
+{
+    // Tiles are black where there are no stars, adding them leaves the
+    // world's clear color as it was
+    BeginBlendMode(BLEND_ADDITIVE);
+    for (const auto& layer : layers)
+    {
+        const f32 wave = std::sin(static_cast<f32>(time) * layer.twinkle_speed + layer.twinkle_phase);
+        const f32 brightness = Util::lerp(layer.min_brightness, 1.0f, 0.5f + 0.5f * wave);
+
+        // A layer point shows up where it is plus how far the camera got
+        // times what the layer lags behind, the source is the view moved back by that
+        const Rectangle source {
+            center.x * layer.parallax - half_width,
+            center.y * layer.parallax - half_height,
+            half_width * 2,
+            half_height * 2
+        };
+        const Rectangle dest {
+            center.x - half_width - camera.x,
+            center.y - half_height - camera.y,
+            half_width * 2,
+            half_height * 2
+        };
+        DrawTexturePro(layer.tile.texture, source, dest, { 0.0f, 0.0f }, 0.0f, Color{ 255, 255, 255, static_cast<u8>(brightness * 255.0f) });
+    }
+    EndBlendMode();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <types.h>
+
+#include <raylib.h>
+#include <vector>
+
+// The starfield behind the world. Each layer's stars are drawn once into a
+// texture that repeats across the whole plane, and every frame only takes
+// a single quad per layer. Layers move with the camera by their own
+// parallax factor, further ones slower, and twinkle as a whole by fading
+// their brightness up and down.
+class Background
+{
+public:
+    // Needs a window, the layers live on the GPU. The same seed gives the
+    // same stars.
+    Background(const Texture2D& star, u64 seed);
+    ~Background();
+
+    Background(const Background&) = delete;
+    Background& operator=(const Background&) = delete;
+
+    // Covers the area around center, both in world space. camera is
+    // subtracted from positions like everywhere else in the world, time in
+    // seconds drives the twinkling.
+    void draw(Vector2 center, f32 half_width, f32 half_height, Vector2 camera, f64 time) const;
+
+private:
+    struct Layer
+    {
+        RenderTexture2D tile;
+        f32 parallax;
+        f32 min_brightness;
+        f32 twinkle_speed;
+        f32 twinkle_phase;
+    };
+
+    std::vector<Layer> layers;
+};
@@ -0,0 +1,64 @@
+#include <CommandBuffer.h>
+
+void CommandBuffer::create_projectile(Texture2D& texture, ProjectileType type, Entity owner, f32 x, f32 y, f32 rotation)
+{
+    commands.emplace_back(CreateProjectile { &texture, type, owner, x, y, rotation });
+}
+
+void CommandBuffer::create_pickup(Texture2D& texture, PickupType type, f32 x, f32 y)
+{
+    commands.emplace_back(CreatePickup { &texture, type, x, y });
+}
+
+void CommandBuffer::destroy(entt::entity entity)
+{
+    if (removed.contains(entity)) return;
+
+    removed.push(entity);
+    commands.emplace_back(Destroy { entity });
+}
+
+void CommandBuffer::release_projectile(entt::entity entity)
+{
+    if (removed.contains(entity)) return;
+
+    removed.push(entity);
+    commands.emplace_back(Release { entity });
+}
+
+void CommandBuffer::flush(EntityManager& entity_manager)
+{
+    auto& registry = entity_manager.registry;
+
+    for (auto& command : commands)
+    {
+        if (auto* create = std::get_if<CreateProjectile>(&command))
+        {
+            entity_manager.create_projectile(*create->texture, create->type, create->owner, create->x, create->y, create->rotation);
+        }
+        else if (auto* pickup = std::get_if<CreatePickup>(&command))
+        {
+            entity_manager.create_pickup(*pickup->texture, pickup->type, pickup->x, pickup->y);
+        }
+        else if (auto* destroy = std::get_if<Destroy>(&command))
+        {
+            if (registry.valid(destroy->entity)) registry.destroy(destroy->entity);
+        }
+        else if (auto* release = std::get_if<Release>(&command))
+        {
+            if (registry.valid(release->entity)) entity_manager.release_projectile(Entity(release->entity, &registry));
+        }
+        else if (auto* emplace = std::get_if<Emplace>(&command))
+        {
+            emplace->apply(registry);
+        }
+    }
+
+    clear();
+}
+
+void CommandBuffer::clear()
+{
+    commands.clear();
+    removed.clear();
+}
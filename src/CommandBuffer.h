@@ -0,0 +1,81 @@
+#pragma once
+
+#include <types.h>
+#include <Entity.h>
+#include <EntityManager.h>
+#include <Component.h>
+
+#include <entt/entt.hpp>
+#include <raylib.h>
+#include <functional>
+#include <variant>
+#include <vector>
+
+// Structural changes recorded by systems while they iterate, applied in
+// recording order when the simulation flushes the buffer between systems.
+// Until then every storage stays as it was, entities queued for removal are
+// still valid and have to be skipped with is_removed().
+class CommandBuffer
+{
+public:
+    void create_projectile(Texture2D& texture, ProjectileType type, Entity owner, f32 x, f32 y, f32 rotation);
+    void create_pickup(Texture2D& texture, PickupType type, f32 x, f32 y);
+    void destroy(entt::entity entity);
+    void release_projectile(entt::entity entity);
+
+    template <typename T, typename... Args>
+    void emplace_or_replace(entt::entity entity, Args&&... args)
+    {
+        commands.emplace_back(Emplace { [entity, component = T { std::forward<Args>(args)... }](entt::registry& registry)
+        {
+            if (registry.valid(entity)) registry.emplace_or_replace<T>(entity, component);
+        }});
+    }
+
+    // Destroyed or released by a command that hasn't been applied yet
+    [[nodiscard]] bool is_removed(entt::entity entity) const { return removed.contains(entity); }
+    [[nodiscard]] bool empty() const { return commands.empty(); }
+
+    void flush(EntityManager& entity_manager);
+    // Drops everything recorded, for when the registry is cleared anyway
+    void clear();
+
+private:
+    struct CreateProjectile
+    {
+        Texture2D* texture;
+        ProjectileType type;
+        Entity owner;
+        f32 x;
+        f32 y;
+        f32 rotation;
+    };
+
+    struct CreatePickup
+    {
+        Texture2D* texture;
+        PickupType type;
+        f32 x;
+        f32 y;
+    };
+
+    struct Destroy
+    {
+        entt::entity entity;
+    };
+
+    struct Release
+    {
+        entt::entity entity;
+    };
+
+    struct Emplace
+    {
+        std::function<void(entt::registry&)> apply;
+    };
+
+    using Command = std::variant<CreateProjectile, CreatePickup, Destroy, Release, Emplace>;
+
+    std::vector<Command> commands;
+    entt::sparse_set removed;
+};
@@ -45,6 +45,9 @@ enum class PickupType : u8
 
 namespace Component
 {
+    // Pooled entity that is waiting to be reused, systems skip these
+    struct Inactive {};
+
     struct Pickup
     {
         PickupType type { PickupType::COINS };
@@ -58,24 +61,17 @@ namespace Component
         f32 radius { 0.0f };
     };
 
-    struct Effect
-    {
-        EffectType type;
-        f32 lifetime { 1.0f };
-    };
-
     struct Projectile
     {
         Color color { GRAY };
         u32 damage { 0 };
         Entity owner;
         ProjectileType type;
-    };
 
-    struct Star {
-        bool growing { false };
-        static inline f32 max_scale { 0.25f };
-        static inline f32 min_scale { 0.0f };
+        // Homing projectiles only
+        entt::entity target { entt::null };
+        f32 retarget_timer { 0.0f };
+        static constexpr f32 RETARGET_INTERVAL = 0.25f;
     };
 
     struct Health {
@@ -131,6 +127,14 @@ namespace Component
         f32 scale { 1.0f };
         Vector2 size { 32.0f, 32.0f };
     };
+
+    // Transform as of the previous simulation tick, used to interpolate
+    // rendering between ticks. Only given to entities that move.
+    struct PreviousTransform
+    {
+        f32 rotation { 0 };
+        Vector2 pos { 0, 0 };
+    };
 }
 
 #endif //LIMITEDSPACE_COMPONENT_H
@@ -4,6 +4,40 @@
 #include <Util.h>
 
 #include <vector>
+#include <algorithm>
+
+EntityManager::EntityManager(u32 projectile_capacity)
+    : projectile_capacity(projectile_capacity)
+{
+    prepare_storages();
+    create_groups();
+}
+
+void EntityManager::prepare_storages()
+{
+    // Projectiles are the most frequently created entities, reserve their
+    // storage up front so firefights don't grow it
+    registry.storage<Component::Projectile>().reserve(projectile_capacity);
+    registry.storage<Component::Inactive>().reserve(projectile_capacity);
+    registry.storage<Component::CircleCollider>().reserve(projectile_capacity);
+    registry.storage<Component::Sprite>().reserve(projectile_capacity);
+    registry.storage<Component::Health>().reserve(projectile_capacity);
+    registry.storage<Component::Transform>().reserve(projectile_capacity);
+    registry.storage<Component::PreviousTransform>().reserve(projectile_capacity);
+    registry.storage<Component::Physics>().reserve(projectile_capacity);
+
+    // Systems look storages up from several threads at once, which is only
+    // safe as long as none of them has to be created on the way
+    registry.storage<Component::Player>();
+    registry.storage<Component::Enemy>();
+    registry.storage<Component::Pickup>();
+}
+
+void EntityManager::create_groups()
+{
+    moving_group();
+    projectile_group();
+}
 
 Entity EntityManager::create_entity()
 {
@@ -11,6 +45,21 @@ Entity EntityManager::create_entity()
     return Entity(entity, &registry);
 }
 
+void EntityManager::clear()
+{
+    registry.clear();
+    peak_active_projectiles = 0;
+}
+
+void EntityManager::replace_registry(entt::registry&& loaded)
+{
+    registry = std::move(loaded);
+    peak_active_projectiles = 0;
+
+    prepare_storages();
+    create_groups();
+}
+
 Entity EntityManager::create_enemy_ship(Texture2D& texture, EnemyType type, f32 x, f32 y, f32 rotation)
 {
     std::vector<Color> colors = {
@@ -113,6 +162,7 @@ Entity EntityManager::create_enemy_ship(Texture2D& texture, EnemyType type, f32
             Vector2{ x, y },
             scale,
             Vector2{ size_x, size_y });
+    entity.add_component<Component::PreviousTransform>(rotation, Vector2{ x, y });
     entity.add_component<Component::Physics>(thrust, Vector2{ 0.0f, 0.0f }, Vector2{ 0.0f, 0.0f });
     return entity;
 }
@@ -129,22 +179,11 @@ Entity EntityManager::create_player(Texture2D& texture, f32 x, f32 y, f32 rotati
     entity.add_component<Component::Sprite>(&texture, (u32) 0, (u32) 0, Util::pick_random_from_vector(colors));
     entity.add_component<Component::Health>(true, false, 0, 100);
     entity.add_component<Component::Transform>(rotation, Vector2{ x, y }, 1.0f, Vector2{ 32.0f, 32.0f });
+    entity.add_component<Component::PreviousTransform>(rotation, Vector2{ x, y });
     entity.add_component<Component::Physics>(50.0f, Vector2{ 0.0f, 0.0f }, Vector2{ 0.0f, 0.0f });
     return entity;
 }
 
-Entity EntityManager::create_star(Texture2D& texture, f32 x, f32 y)
-{
-    auto rotation = Util::random_f32(0.0f, 2.0f * static_cast<f32>(M_PI));
-    auto scale = Util::random_f32(Component::Star::min_scale, Component::Star::max_scale);
-
-    auto entity = create_entity();
-    entity.add_component<Component::Star>();
-    entity.add_component<Component::Sprite>(&texture);
-    entity.add_component<Component::Transform>(rotation, Vector2{ x, y }, scale, Vector2{ 32.0f, 32.0f });
-    return entity;
-}
-
 Entity EntityManager::create_projectile(Texture2D& texture, ProjectileType type, Entity owner, f32 x, f32 y, f32 rotation)
 {
     u32 offset_x = 0;
@@ -193,33 +232,53 @@ Entity EntityManager::create_projectile(Texture2D& texture, ProjectileType type,
         }
     }
 
-    auto entity = create_entity();
-    entity.add_component<Component::Projectile>(color, damage, owner, type);
-    entity.add_component<Component::CircleCollider>(5.0f);
-    entity.add_component<Component::Sprite>(&texture, offset_x, (u32) 0);
-    entity.add_component<Component::Health>(true, false, 0, 1);
-    entity.add_component<Component::Transform>(rotation, Vector2{ x, y }, 1.0f, Vector2{ size, size });
-    entity.add_component<Component::Physics>(thrust, Vector2{ 0.0f, 0.0f }, Vector2{ 0.0f, 0.0f });
-    return entity;
+    // Reuse a pooled projectile if there is one, its components are overwritten in place
+    entt::entity handle = entt::null;
+    auto& inactive = registry.storage<Component::Inactive>();
+    if (!inactive.empty())
+    {
+        handle = *inactive.begin();
+        inactive.remove(handle);
+    }
+    else
+    {
+        handle = registry.create();
+    }
+
+    registry.emplace_or_replace<Component::Projectile>(handle, color, damage, owner, type);
+    registry.emplace_or_replace<Component::CircleCollider>(handle, 5.0f);
+    registry.emplace_or_replace<Component::Sprite>(handle, &texture, offset_x, (u32) 0);
+    registry.emplace_or_replace<Component::Health>(handle, true, false, 0, 1);
+    registry.emplace_or_replace<Component::Transform>(handle, rotation, Vector2{ x, y }, 1.0f, Vector2{ size, size });
+    registry.emplace_or_replace<Component::PreviousTransform>(handle, rotation, Vector2{ x, y });
+    registry.emplace_or_replace<Component::Physics>(handle, thrust, Vector2{ 0.0f, 0.0f }, Vector2{ 0.0f, 0.0f });
+
+    const auto stats = get_projectile_pool_stats();
+    peak_active_projectiles = std::max(peak_active_projectiles, stats.active);
+
+    return Entity(handle, &registry);
 }
 
-Entity EntityManager::create_effect(Texture2D& texture, EffectType type, f32 x, f32 y, f32 lifetime)
+void EntityManager::release_projectile(Entity projectile)
 {
-    Vector2 size { 32.0f, 32.0f };
-
-    if (type == EffectType::SPARKS)
+    if (!registry.all_of<Component::Inactive>(projectile))
     {
-        size = { Util::random_f32(5.0f, 8.0f), Util::random_f32(5.0f, 8.0f) };
+        registry.emplace<Component::Inactive>(projectile);
     }
+}
 
-    auto rotation = Util::random_f32(0.0f, 2.0f * M_PI);
-    auto scale = Util::random_f32(0.75f, 1.25f);
+ProjectilePoolStats EntityManager::get_projectile_pool_stats() const
+{
+    // Const storage lookups return pointers, both were created in the constructor
+    const auto* projectiles = registry.storage<Component::Projectile>();
+    const auto* inactive = registry.storage<Component::Inactive>();
 
-    auto entity = create_entity();
-    entity.add_component<Component::Sprite>(&texture);
-    entity.add_component<Component::Effect>(type, lifetime);
-    entity.add_component<Component::Transform>(rotation, Vector2{ x, y }, scale, size);
-    return entity;
+    ProjectilePoolStats stats {};
+    stats.inactive = static_cast<u32>(inactive->size());
+    stats.active = static_cast<u32>(projectiles->size()) - stats.inactive;
+    stats.peak_active = std::max(peak_active_projectiles, stats.active);
+    stats.reserved = std::max(projectile_capacity, static_cast<u32>(projectiles->capacity()));
+    return stats;
 }
 
 Entity EntityManager::create_pickup(Texture2D& texture, PickupType type, f32 x, f32 y)
@@ -7,19 +7,59 @@
 
 #include <Component.h>
 
+struct ProjectilePoolStats
+{
+    u32 active { 0 };
+    u32 inactive { 0 };
+    u32 peak_active { 0 };
+    u32 reserved { 0 };
+};
+
 class EntityManager
 {
 public:
-    EntityManager() = default;
+    explicit EntityManager(u32 projectile_capacity = 2048);
 
     Entity create_entity();
 
+    // Destroys every entity, pooled projectiles included. Storage capacity is kept.
+    void clear();
+    // Takes over a registry filled without groups, as restored from a
+    // snapshot. The groups are created afterwards, which sorts the owned
+    // storages only as far as they aren't in group order already. Entities
+    // point to the registry by address, which stays the same.
+    void replace_registry(entt::registry&& loaded);
+
     Entity create_pickup(Texture2D& texture, PickupType type, f32 x, f32 y);
     Entity create_player(Texture2D& texture, f32 x, f32 y, f32 rotation);
     Entity create_enemy_ship(Texture2D& texture, EnemyType type, f32 x, f32 y, f32 rotation);
-    Entity create_star(Texture2D& texture, f32 x, f32 y);
     Entity create_projectile(Texture2D& texture, ProjectileType type, Entity owner, f32 x, f32 y, f32 rotation);
-    Entity create_effect(Texture2D& texture, EffectType type, f32 x, f32 y, f32 lifetime = 1.0f);
+
+    // Parks the projectile in the pool instead of destroying it
+    void release_projectile(Entity projectile);
+    [[nodiscard]] ProjectilePoolStats get_projectile_pool_stats() const;
+
+    // The owning group keeps Transform and Physics packed in the same order
+    // at the front of their storages, so the movement systems walk plain
+    // arrays. Only one group may own a storage and this EnTT can't combine
+    // it with a partial owning group over the same types, so projectiles get
+    // a non-owning group, a packed list of exactly the active projectiles.
+    auto moving_group()
+    {
+        return registry.group<Component::Transform, Component::Physics>(entt::get<>, entt::exclude<Component::Inactive>);
+    }
+    auto projectile_group()
+    {
+        return registry.group<>(entt::get<Component::Projectile, Component::Transform, Component::Physics>, entt::exclude<Component::Inactive>);
+    }
 
     entt::registry registry;
+
+private:
+    void prepare_storages();
+    // Groups track entities from the moment they exist
+    void create_groups();
+
+    u32 projectile_capacity;
+    u32 peak_active_projectiles { 0 };
 };
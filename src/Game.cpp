@@ -1,17 +1,23 @@
 #include <Game.h>
 #include <Component.h>
 #include <Util.h>
-#include <System.h>
+#include <Random.h>
+#include <Snapshot.h>
 
 #include <rlgl.h>
 #include <iostream>
 #include <cmath>
+#include <cstdio>
 
 #define SQRT_2 1.41421354
-#define PI2 (2 * PI)
 
 namespace
 {
+    constexpr const char* QUICKSAVE_FILE = "quicksave.snap";
+    // Written every AUTOSAVE_INTERVAL seconds of play, --resume picks it up after a crash
+    constexpr const char* AUTOSAVE_FILE = "autosave.snap";
+    constexpr f32 AUTOSAVE_INTERVAL = 30.0f;
+
     std::string projectile_type_to_string(ProjectileType type)
     {
         switch(type)
@@ -24,6 +30,51 @@ namespace
         return "???";
     }
 
+    // Blends the state of the last two simulation ticks, entities created
+    // during the last tick are drawn where they are.
+    Component::Transform interpolate_transform(entt::registry& registry,
+                                               entt::entity entity,
+                                               const Component::Transform& transform,
+                                               f32 alpha)
+    {
+        auto* previous = registry.try_get<Component::PreviousTransform>(entity);
+        if (previous == nullptr) return transform;
+
+        f32 rotation_diff = transform.rotation - previous->rotation;
+        if (rotation_diff > PI) {
+            rotation_diff -= 2 * PI;
+        } else if (rotation_diff < -PI) {
+            rotation_diff += 2 * PI;
+        }
+
+        Component::Transform result = transform;
+        result.pos.x = Util::lerp(previous->pos.x, transform.pos.x, alpha);
+        result.pos.y = Util::lerp(previous->pos.y, transform.pos.y, alpha);
+        result.rotation = previous->rotation + rotation_diff * alpha;
+        return result;
+    }
+
+    // Covers movement between ticks for culling on the uninterpolated transform
+    constexpr f32 CULL_MARGIN = 32.0f;
+
+    bool is_visible(const CullBounds& bounds, Vector2 pos, f32 extent)
+    {
+        const f32 dx = pos.x - bounds.center.x;
+        const f32 dy = pos.y - bounds.center.y;
+        if (std::fabs(dx) > bounds.half_width + extent || std::fabs(dy) > bounds.half_height + extent)
+        {
+            return false;
+        }
+        const f32 reach = bounds.radius + extent;
+        return dx * dx + dy * dy <= reach * reach;
+    }
+
+    // Half the diagonal of the sprite's quad, the furthest it reaches at any rotation
+    f32 sprite_extent(const Component::Transform& transform)
+    {
+        return std::max(transform.size.x, transform.size.y) * transform.scale * static_cast<f32>(SQRT_2) / 2 + CULL_MARGIN;
+    }
+
     void render_centered_text(const char* text, f32 y, u32 font_size, const Color& color)
     {
         f32 w = GetScreenWidth();
@@ -33,117 +84,165 @@ namespace
 }
 
 Game::Game(const GameSpecification& spec)
+    : offscreen_world(spec.offscreen_world)
+    , resolution(std::clamp(spec.min_resolution_scale, 0.1f, 1.0f), std::clamp(spec.max_resolution_scale, 0.1f, 1.0f), 1.0f / spec.target_fps)
+    , tick_dt(1.0f / spec.tick_rate)
+    , max_ticks_per_frame(std::max(spec.max_ticks_per_frame, 1u))
 {
+    if (!spec.replay_file.empty())
+    {
+        const auto recorded = Replay::read(spec.replay_file);
+        if (!recorded.has_value())
+        {
+            std::cerr << "Unable to load replay '" << spec.replay_file << "'\n";
+            std::exit(1);
+        }
+        replay = recorded.value();
+        tick_dt = replay.tick_dt;
+        playing_back = true;
+    }
+    else
+    {
+        // Unseeded sessions get a seed too, so any of them can be recorded
+        replay.seed = spec.seed.value_or(Random::current_seed());
+        replay.tick_dt = tick_dt;
+        record_file = spec.record_file;
+        resume_file = spec.resume_file;
+    }
+    Random::seed(replay.seed);
 
     if (spec.resizable_window) SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(1024, 1024, "Astralinda");
     this->assets.screen = LoadRenderTexture(spec.width, spec.height);
+    // Stretched over more pixels than it has below full resolution
+    SetTextureFilter(this->assets.screen.texture, TEXTURE_FILTER_BILINEAR);
+
+    // Nothing in here touches the assets before setup_level, the workers
+    // can start on the files right away
+    sound_manger = std::make_unique<SoundManager>(this->assets, std::make_unique<RaylibAudioBackend>());
+    simulation = std::make_unique<Simulation>(assets, *sound_manger);
+    sprite_batch = std::make_unique<SpriteBatch>();
+    if (spec.rewind_budget > 0) rewind = std::make_unique<RewindBuffer>(spec.rewind_budget);
 
     load_assets();
-    setup_level(level_index);
 }
 
-void Game::setup_level(u32 level_index)
+void Game::load_assets()
 {
-    if (level_index >= this->assets.levels.size())
+    loader = std::make_unique<AssetLoader>(simulation->jobs);
+    // Pre-decoded by the pack_assets build step, the files below are the fallback
+    loader->open_archive("assets.pak");
+
+    // First in line, the loading screen shows it as soon as it's there
+    loader->add_texture(this->assets.title, "assets/title.png");
+    loader->add_texture(this->assets.warning, "assets/warning.png");
+
+    // Sheets used by world sprites also go into the sprite batch's atlas
+    loader->add_texture(this->assets.ships, "assets/ships.png", true);
+    loader->add_texture(this->assets.effects, "assets/effects.png", true);
+    loader->add_texture(this->assets.projectiles, "assets/projectiles.png", true);
+    loader->add_texture(this->assets.engine, "assets/engine.png", true);
+    loader->add_texture(this->assets.pickups, "assets/pickups.png", true);
+    // Only drawn into the background's tiles
+    loader->add_texture(this->assets.stars, "assets/stars.png");
+
+    loader->add_sound(this->assets.ship_death, "assets/ship_death.ogg");
+    loader->add_sound(this->assets.hit_laser1, "assets/hit_laser1.ogg");
+    loader->add_sound(this->assets.hit_laser2, "assets/hit_laser2.ogg");
+    loader->add_sound(this->assets.hit1, "assets/hit1.ogg");
+    loader->add_sound(this->assets.hit2, "assets/hit2.ogg");
+    loader->add_sound(this->assets.hit3, "assets/hit3.ogg");
+    loader->add_sound(this->assets.shoot1, "assets/shoot.ogg");
+    loader->add_sound(this->assets.game_over1, "assets/game_over.ogg");
+    loader->add_sound(this->assets.no_ammo, "assets/no_ammo.ogg");
+    loader->add_sound(this->assets.pickup, "assets/pickup.ogg");
+
+    loader->add_levels(this->assets.levels, "assets/levels.json");
+
+    loader->start();
+}
+
+void Game::finish_loading()
+{
+    if (loader->get_failed_file() != nullptr)
     {
-        game_won = true;
-        return;
+        std::cerr << "Unable to load '" << loader->get_failed_file() << "'\n";
+        std::exit(1);
     }
 
-    auto level = this->assets.levels.at(level_index);
+    sprite_batch->build_atlas(loader->get_sheets());
+    loader.reset();
+    background = std::make_unique<Background>(assets.stars, replay.seed);
 
-    bonus_timer = static_cast<f32>(level.bonus_time_seconds);
-    game_over = false;
-    level_fade = 0.0f;
-    entity_manager.registry.clear();
-    circle_radius = static_cast<f32>(level.circle_radius);
+    // A snapshot that doesn't load leaves the first level set up instead
+    if (resume_file.empty() || !load_snapshot(resume_file)) simulation->setup_level(0);
+    else game_start = true;
 
-    // PLAYER
-    {
-        // Keep thrust and multi-shot upgrades
-        f32 thrust = 50.0f;
-        u32 multi_shot = 1;
-        if (level_index > 0 && player.has_component<Component::Physics>())
-        {
-            thrust = player.get_component<Component::Physics>().thrust;
-        }
-        if (level_index > 0 && player.has_component<Component::Player>())
-        {
-            multi_shot = player.get_component<Component::Player>().multi_shot_amount;
-        }
+    // The recording starts with the first tick, the title screen is skipped
+    if (playing_back) game_start = true;
+}
 
-        // Respawn player
-        Vector2 pos = Util::get_polar_coordinates(PI2 * 0.75f, circle_radius - 64);
-        f32 angle = Util::get_angle_between_points(pos, { 0.0f, 0.0f });
-        this->player = entity_manager.create_player(this->assets.ships, pos.x, pos.y, angle);
-        this->player.get_component<Component::Physics>().thrust = thrust;
-        this->player.get_component<Component::Player>().multi_shot_amount = multi_shot;
-    }
-    // ENEMIES
+void Game::update_simulation()
+{
+    if (playing_back && replay_tick < replay.get_tick_count())
     {
-        Util::shuffle_vector(level.enemy_types);
-        const auto angles = Util::get_evenly_spaced_angles(level.enemy_types.size());
-        for (u32 i = 0; i < level.enemy_types.size(); ++i)
-        {
-            auto type = level.enemy_types.at(i);
-            Vector2 pos = Util::get_polar_coordinates(angles.at(i), circle_radius - 100);
-            f32 angle = Util::get_angle_between_points(pos, { 0.0f, 0.0f });
-            entity_manager.create_enemy_ship(this->assets.ships, type, pos.x, pos.y, angle);
-        }
+        const auto death_distance = replay.get_death_distance(replay_tick);
+        if (death_distance.has_value()) simulation->death_distance = death_distance.value();
+        simulation->update(tick_dt, replay.get_input(replay_tick));
+        if (rewind != nullptr) rewind->record(*simulation);
+        replay_tick += 1;
+
+        // Once it ran out the keyboard takes over
+        playing_back = replay_tick < replay.get_tick_count();
+        return;
     }
-    // STARS
-    for (u32 i = 0; i < 100; i++)
+
+    if (!record_file.empty()) replay.record(pending_input, simulation->death_distance);
+    simulation->update(tick_dt, pending_input);
+    if (rewind != nullptr) rewind->record(*simulation);
+    pending_input.consume_pressed();
+}
+
+bool Game::save_snapshot(const std::string& file)
+{
+    ProfileScope scope(simulation->profiler, "save_snapshot");
+    simulation->save_snapshot(snapshot_bytes);
+    if (!Snapshot::write_file(file, snapshot_bytes))
     {
-        Vector2 pos = Util::get_polar_coordinates(
-                Util::random_f32(0.0f, 2.0f * M_PI),
-                Util::random_f32(0, circle_radius + 1000));
-        entity_manager.create_star(this->assets.stars, pos.x, pos.y);
+        std::cerr << "Unable to write '" << file << "'\n";
+        return false;
     }
+    return true;
 }
 
-void Game::load_assets()
+bool Game::load_snapshot(const std::string& file)
 {
-    this->assets.title = LoadTexture("assets/title.png");
-    this->assets.ships = LoadTexture("assets/ships.png");
-    this->assets.stars = LoadTexture("assets/stars.png");
-    this->assets.effects = LoadTexture("assets/effects.png");
-    this->assets.projectiles = LoadTexture("assets/projectiles.png");
-    this->assets.engine = LoadTexture("assets/engine.png");
-    this->assets.warning = LoadTexture("assets/warning.png");
-    this->assets.pickups = LoadTexture("assets/pickups.png");
-
-    InitAudioDevice();
-    this->assets.ship_death = LoadSound("assets/ship_death.ogg");
-    SetSoundVolume(this->assets.ship_death, 0.25f);
-    this->assets.hit_laser1 = LoadSound("assets/hit_laser1.ogg");
-    SetSoundVolume(this->assets.hit_laser1, 0.25f);
-    this->assets.hit_laser2 = LoadSound("assets/hit_laser2.ogg");
-    SetSoundVolume(this->assets.hit_laser2, 0.25f);
-    this->assets.hit1 = LoadSound("assets/hit1.ogg");
-    SetSoundVolume(this->assets.hit1, 0.25f);
-    this->assets.hit2 = LoadSound("assets/hit2.ogg");
-    SetSoundVolume(this->assets.hit2, 0.25f);
-    this->assets.hit3 = LoadSound("assets/hit3.ogg");
-    SetSoundVolume(this->assets.hit3, 0.25f);
-    this->assets.shoot1 = LoadSound("assets/shoot.ogg");
-    SetSoundVolume(this->assets.shoot1, 0.25f);
-    this->assets.game_over1 = LoadSound("assets/game_over.ogg");
-    SetSoundVolume(this->assets.game_over1, 0.25f);
-    this->assets.no_ammo = LoadSound("assets/no_ammo.ogg");
-    SetSoundVolume(this->assets.no_ammo, 0.25f);
-    this->assets.pickup = LoadSound("assets/pickup.ogg");
-    SetSoundVolume(this->assets.pickup, 0.25f);
-
-    const auto levels_optional = Loader::load_levels("assets/levels.json");
-    if (!levels_optional.has_value())
+    const auto bytes = Snapshot::read_file(file);
+    if (!bytes.has_value() || !simulation->load_snapshot(bytes.value()))
     {
-        std::cerr << "Unable to load 'assets/levels.json'";
-        std::exit(1);
+        std::cerr << "Unable to load snapshot '" << file << "'\n";
+        return false;
     }
-    this->assets.levels = levels_optional.value();
 
-    sound_manger = std::make_unique<SoundManager>(this->assets);
+    leave_replay();
+    if (rewind != nullptr) rewind->clear();
+
+    tick_accumulator = 0.0f;
+    // Loading took a frame of its own
+    resolution.reset();
+    pending_input = {};
+    std::cout << "Loaded " << file << "\n";
+    return true;
+}
+
+void Game::leave_replay()
+{
+    if (!record_file.empty())
+    {
+        std::cerr << "Jumped in time, '" << record_file << "' won't be written\n";
+        record_file.clear();
+    }
+    playing_back = false;
 }
 
 void Game::run()
@@ -152,10 +251,68 @@ void Game::run()
     {
         f32 dt = GetFrameTime();
 
-        if (game_start)
+        if (IsKeyPressed(KEY_F2)) show_profiler = !show_profiler;
+        if (IsKeyPressed(KEY_F3))
+        {
+            if (simulation->profiler.write_csv("profile.csv")) std::cout << "Wrote profile.csv\n";
+            else std::cerr << "Unable to write 'profile.csv'\n";
+        }
+        if (IsKeyPressed(KEY_F4)) offscreen_world = !offscreen_world;
+
+        if (loader != nullptr)
+        {
+            if (loader->update()) finish_loading();
+            else render_loading();
+        }
+        else if (game_start)
         {
-            update(dt);
-            render();
+            simulation->profiler.begin_frame();
+            simulation->death_distance = static_cast<f32>(GetScreenWidth() * 2 * SQRT_2);
+
+            if (IsKeyPressed(KEY_F5) && save_snapshot(QUICKSAVE_FILE)) std::cout << "Wrote " << QUICKSAVE_FILE << "\n";
+            if (IsKeyPressed(KEY_F9)) load_snapshot(QUICKSAVE_FILE);
+
+            autosave_timer += dt;
+            if (autosave_timer >= AUTOSAVE_INTERVAL)
+            {
+                save_snapshot(AUTOSAVE_FILE);
+                autosave_timer = 0.0f;
+            }
+
+            // Held down, the ticks run backwards as fast as they were played
+            const bool was_rewinding = rewinding;
+            rewinding = rewind != nullptr && IsKeyDown(KEY_BACKSPACE);
+            if (rewinding)
+            {
+                leave_replay();
+                pending_input = {};
+            }
+            else
+            {
+                if (was_rewinding) rewind->resume(*simulation);
+                pending_input.accumulate(poll_input());
+            }
+
+            // Run the simulation in fixed steps, a slow frame catches up with
+            // several ticks instead of one big one
+            tick_accumulator += dt;
+            tick_accumulator = std::min(tick_accumulator, tick_dt * static_cast<f32>(max_ticks_per_frame));
+            {
+                ProfileScope scope(simulation->profiler, "simulation");
+                while (tick_accumulator >= tick_dt)
+                {
+                    if (rewinding) rewind->step_back(*simulation);
+                    else update_simulation();
+                    tick_accumulator -= tick_dt;
+                }
+            }
+            sound_manger->flush();
+
+            render(tick_accumulator / tick_dt);
+            simulation->profiler.end_frame();
+
+            // A paused frame has nothing new to draw, it says little about the next ones
+            if (!simulation->pause) resolution.add_frame(dt);
         }
         else
         {
@@ -178,170 +335,68 @@ void Game::run()
 
         }
     }
-    CloseWindow();
-}
-
-
-void Game::update_player(f32 dt)
-{
-    auto& player_component = player.get_component<Component::Player>();
-    auto& player_transform = player.get_component<Component::Transform>();
-    auto& player_physics = player.get_component<Component::Physics>();
-
-    if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W)) {
-        player_physics.acc.x += std::cos(player_transform.rotation) * player_physics.thrust * dt;
-        player_physics.acc.y += std::sin(player_transform.rotation) * player_physics.thrust * dt;
-        const f32 magnitude = player_physics.acc.x * player_physics.acc.x + player_physics.acc.y * player_physics.acc.y;
-
-        // Generate sparks when accelerating fast
-        if (magnitude > 800 && Util::random_f32(0.0f, 1.0f) <= 0.01f)
-        {
-            f32 spread = Util::lerp(2.0f, 8.0f, magnitude / 2500.0f);
-            entity_manager.create_effect(
-                    assets.effects,
-                    EffectType::SPARKS,
-                    player_transform.pos.x + Util::random_f32(-spread, spread),
-                    player_transform.pos.y + Util::random_f32(-spread, spread),
-                    Util::random_f32(1.5f, 4.0f));
-        }
-    }
 
-    if (IsKeyDown(KEY_ONE))
+    if (!record_file.empty())
     {
-        player_component.projectile_type = ProjectileType::SHELL;
+        if (replay.write(record_file)) std::cout << "Wrote " << record_file << "\n";
+        else std::cerr << "Unable to write '" << record_file << "'\n";
     }
 
-    if (IsKeyDown(KEY_TWO))
-    {
-        player_component.projectile_type = ProjectileType::LASER;
-    }
-
-    if (IsKeyDown(KEY_THREE))
-    {
-        player_component.projectile_type = ProjectileType::ROCKET;
-    }
-
-    if (IsKeyDown(KEY_FOUR))
-    {
-        player_component.projectile_type = ProjectileType::HOMING;
-    }
+    // GPU resources have to go before the context does
+    sprite_batch.reset();
+    background.reset();
+    if (world_target.id != 0) UnloadRenderTexture(world_target);
+    CloseWindow();
+}
 
+void Game::render_loading() const
+{
+    const f32 window_width = GetScreenWidth();
+    const f32 window_height = GetScreenHeight();
 
-    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) {
-        player_transform.rotation += 3.0f * dt;
-    }
+    BeginDrawing();
+    ClearBackground(Color{ 15, 15, 15, 255 });
 
-    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) {
-        player_transform.rotation -= 3.0f * dt;
+    if (assets.title.id > 0)
+    {
+        DrawTexturePro(
+                assets.title,
+                {0.0f, 0.0f, 2048.0f, 2048.0f},
+                { 0.0f, 0.0f, window_width, window_height },
+                { 0.0f, 0.0f },
+                0.0f,
+                WHITE);
     }
 
-    if (player_component.shoot_delay > 0) player_component.shoot_delay -= 3.0f * dt;
-
-    if (IsKeyPressed(KEY_SPACE) && player_component.shoot_delay <= 0) {
-        for (u32 i = 0; i < player_component.multi_shot_amount; ++i)
-        {
-
-            if (player_component.projectile_type == ProjectileType::LASER ||
-               (player_component.projectile_type == ProjectileType::SHELL && player_component.shell_amount > 0) ||
-               (player_component.projectile_type == ProjectileType::ROCKET && player_component.rocket_amount > 0) ||
-               (player_component.projectile_type == ProjectileType::HOMING && player_component.homing_amount > 0))
-            {
-                sound_manger->play_shoot();
-                entity_manager.create_projectile(assets.projectiles, player_component.projectile_type, player, player_transform.pos.x, player_transform.pos.y, player_transform.rotation);
-                player_component.shoot_delay = 1.0f;
-
-                if (player_component.projectile_type == ProjectileType::SHELL)  player_component.shell_amount -= 1;
-                if (player_component.projectile_type == ProjectileType::ROCKET) player_component.rocket_amount -= 1;
-                if (player_component.projectile_type == ProjectileType::HOMING) player_component.homing_amount -= 1;
+    const f32 bar_width = window_width / 2;
+    const f32 bar_x = (window_width - bar_width) / 2;
+    const f32 bar_y = window_height - 80;
+    DrawRectangleRounded({bar_x, bar_y, Util::lerp(0, bar_width, loader->get_progress()), 30}, 4, 10, WHITE);
+    DrawRectangleRoundedLines({bar_x, bar_y, bar_width, 30}, 4, 10, 4, WHITE);
 
-            } else {
-                sound_manger->play_no_ammo();
-            }
-        }
-    }
-
-    if (player_transform.rotation < 0) {
-        player_transform.rotation += 2 * PI;
-    } else if (player_transform.rotation >= 2 * PI) {
-        player_transform.rotation -= 2 * PI;
-    }
+    EndDrawing();
 }
 
-void Game::update(f32 dt)
+Input Game::poll_input() const
 {
-    if (IsKeyPressed(KEY_L))
-    {
-        setup_level(++level_index);
-    }
-
-    // Check if level finished
-    auto view = entity_manager.registry.view<Component::Enemy>();
-    u32 enemy_count = static_cast<u32>(std::distance(view.begin(), view.end()));
-    if (enemy_count == 0 || game_over)
-    {
-        if (level_fade == 0.0f && bonus_timer > 0.0f)
-        {
-            auto& player_component = player.get_component<Component::Player>();
-            player_component.score += this->assets.levels[level_index].bonus_score;
-        }
-
-        level_fade += 2.0f * dt;
-        level_fade = std::min(level_fade, 1.0f);
-
-        if (level_fade >= 0.95f && IsKeyPressed(KEY_ENTER))
-        {
-            if (game_over)
-            {
-                level_index = 0;
-                setup_level(level_index);
-            } else {
-                setup_level(++level_index);
-            }
-        }
-        return;
-    }
-
-    // Pause
-
-    if (IsKeyPressed(KEY_P)) {
-        pause = !pause;
-    }
-    if (pause) return;
-
-    // Update game entities
-
-    SystemContext context {
-        player,
-        entity_manager,
-        *sound_manger,
-        assets,
-        circle_radius,
-        static_cast<f32>(GetScreenWidth() * 2 * SQRT_2),
-        game_over
-    };
-
-    // Make circle smaller
-    circle_radius -= 3.0f * dt;
-    circle_radius = std::max(circle_radius, 100.0f);
-
-    // Increase bonus timer
-    bonus_timer -= 1.0f * dt;
-    bonus_timer = std::max(bonus_timer, 0.0f);
-
-    update_player(dt);
-    System::update_stars(context, dt);
-    System::update_projectiles(context, dt);
-    System::update_enemies(context, dt);
-    System::update_physics(context, dt);
-    System::update_effects(context, dt);
-    System::update_projectile_collisions(context, dt);
-    System::update_player_enemy_collisions(context, dt);
-    System::update_player_pickup_collisions(context, dt);
-    System::update_health_circle_radius(context, dt);
-    System::update_pickups(context, dt);
+    Input input {};
+
+    if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W))        input.set(InputAction::THRUST);
+    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A))      input.set(InputAction::ROTATE_LEFT);
+    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D))     input.set(InputAction::ROTATE_RIGHT);
+    if (IsKeyPressed(KEY_SPACE))                      input.set(InputAction::SHOOT);
+    if (IsKeyDown(KEY_ONE))                           input.set(InputAction::SELECT_SHELL);
+    if (IsKeyDown(KEY_TWO))                           input.set(InputAction::SELECT_LASER);
+    if (IsKeyDown(KEY_THREE))                         input.set(InputAction::SELECT_ROCKET);
+    if (IsKeyDown(KEY_FOUR))                          input.set(InputAction::SELECT_HOMING);
+    if (IsKeyPressed(KEY_P))                          input.set(InputAction::PAUSE);
+    if (IsKeyPressed(KEY_L))                          input.set(InputAction::SKIP_LEVEL);
+    if (IsKeyPressed(KEY_ENTER))                      input.set(InputAction::CONFIRM);
+
+    return input;
 }
 
-void Game::render()
+void Game::render(f32 alpha)
 {
     f32 width = assets.screen.texture.width;
     f32 height = assets.screen.texture.height;
@@ -349,128 +404,124 @@ void Game::render()
     f32 window_width = GetScreenWidth();
     f32 window_height = GetScreenHeight();
 
-    auto& player_transform = player.get_component<Component::Transform>();
-    Vector2 camera {
-        player_transform.pos.x - width / 2,
-        player_transform.pos.y - height / 2
-    };
-
-    if (!pause)
-    {
+    auto& registry = simulation->entity_manager.registry;
 
-        BeginTextureMode(this->assets.screen);
+    auto player_transform = interpolate_transform(registry, simulation->player, simulation->player.get_component<Component::Transform>(), alpha);
 
-        ClearBackground(Color{ 15, 15, 15, 255 });
+    // The blit scales the target so its width maps to the window's longest
+    // side times SQRT_2, whatever rotation the window shows fits in its half diagonal
+    const f32 world_per_pixel = width / (std::max(window_width, window_height) * static_cast<f32>(SQRT_2));
+    const f32 view_radius = std::sqrt(window_width * window_width + window_height * window_height) / 2 * world_per_pixel;
 
-        // Draw entities
-        auto view = entity_manager.registry.view<Component::Transform, Component::Sprite>();
-        for (auto entity : view)
-        {
-            auto [transform, sprite] = view.get<Component::Transform, Component::Sprite>(entity);
-            DrawTexturePro(*sprite.texture,
-                           {static_cast<f32>(sprite.offset_x), static_cast<f32>(sprite.offset_y), transform.size.x, transform.size.y},
-                           {transform.pos.x - camera.x, transform.pos.y - camera.y, transform.size.x * transform.scale, transform.size.y * transform.scale},
-                           {transform.size.x / 2 * transform.scale, transform.size.y / 2 * transform.scale},
-                           (transform.rotation * RAD2DEG) + 90.0f,
-                           sprite.tint);
-        }
-
-        auto view2 = entity_manager.registry.view<Component::Transform, Component::Physics, Component::Sprite>();
-        for (auto entity : view2)
-        {
-            auto [transform, physics, sprite] = view2.get<Component::Transform, Component::Physics, Component::Sprite>(entity);
+    // Below 1 the world is drawn into the top left part of a target and
+    // stretched over the window, the HUD stays at full resolution
+    const f32 resolution_scale = resolution.get_scale();
 
-            if (entity_manager.registry.any_of<Component::Player>(entity))
-            {
-                const f32 magnitude = physics.acc.x * physics.acc.x + physics.acc.y * physics.acc.y;
-                u32 power = std::min((magnitude + 300.0f) / 2300.0f * 4, 4.0f);
-                if (power == 0) continue;
+    Camera2D camera {};
+    camera.offset = { window_width / 2, window_height / 2 };
+    camera.target = player_transform.pos;
+    camera.rotation = -player_transform.rotation * RAD2DEG - 90.0f;
+    camera.zoom = 1.0f / world_per_pixel;
 
-                DrawTexturePro(assets.engine,
-                               { static_cast<float>(power - 1) * transform.size.x, 0, transform.size.x, transform.size.y },
-                               { transform.pos.x - camera.x, transform.pos.y - camera.y, transform.size.x * transform.scale, transform.size.y * transform.scale },
-                               { transform.size.x / 2 * transform.scale - 8, - transform.size.y / 2 + 2 },
-                               (transform.rotation * RAD2DEG) + 90.0f,
-                               WHITE);
-                DrawTexturePro(assets.engine,
-                               { static_cast<float>(power - 1) * transform.size.x, 0, transform.size.x, transform.size.y },
-                               { transform.pos.x - camera.x, transform.pos.y - camera.y, transform.size.x * transform.scale, transform.size.y * transform.scale },
-                               { transform.size.x / 2 * transform.scale + 8, - transform.size.y / 2 + 2 },
-                               (transform.rotation * RAD2DEG) + 90.0f,
-                               WHITE);
-            }
-        }
-
-        // Draw red markers for each enemy
-        auto viewE = entity_manager.registry.view<Component::Transform, Component::Enemy>();
-        for (auto entity : viewE)
-        {
-            auto [transform, enemy] = viewE.get<Component::Transform, Component::Enemy>(entity);
-            auto distance = Util::distance_between_points(player_transform.pos, transform.pos);
-            if (distance < 2000 && distance > 700)
-            {
-                auto angle = Util::get_angle_between_points(player_transform.pos, transform.pos);
-                auto pos = Util::get_polar_coordinates(angle, 300);
-                DrawCircle(player_transform.pos.x + pos.x - camera.x, player_transform.pos.y + pos.y - camera.y, Util::lerp(1.0f, 4.0f, distance / 2000.0f), RED);
-            }
-        }
+    if (offscreen_world && !simulation->pause)
+    {
+        Vector2 corner {
+            player_transform.pos.x - width / 2,
+            player_transform.pos.y - height / 2
+        };
+        const CullBounds cull_bounds { player_transform.pos, width / 2, height / 2, view_radius };
+        offscreen_scale = resolution_scale;
 
-        // Draw shield/health bars
-        auto view3 = entity_manager.registry.view<Component::Transform, Component::Sprite, Component::Health>();
-        for (auto entity : view3)
+        BeginTextureMode(this->assets.screen);
+        BeginScissorMode(0, 0, static_cast<s32>(std::ceil(width * resolution_scale)), static_cast<s32>(std::ceil(height * resolution_scale)));
+        ClearBackground(Color{ 15, 15, 15, 255 });
+        BeginMode2D(Camera2D { { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0.0f, resolution_scale });
+        render_world(alpha, player_transform, corner, cull_bounds, resolution_scale);
+        EndMode2D();
+        EndScissorMode();
+        EndTextureMode();
+    }
+    else if (!offscreen_world && resolution_scale < 1.0f)
+    {
+        if (world_target.texture.width != static_cast<s32>(window_width) || world_target.texture.height != static_cast<s32>(window_height))
         {
-            auto [transform, sprite, health] = view3.get<Component::Transform, Component::Sprite, Component::Health>(entity);
-            if (/*health.show_health_bar*/false && health.health > 0)
-            {
-                Rectangle health_bar_rect = {
-                        transform.pos.x * transform.scale - camera.x,
-                        transform.pos.y * transform.scale - camera.y,
-                        transform.size.x * transform.scale * (health.health / 100.0f),
-                        4
-                };
-                DrawRectanglePro(health_bar_rect,
-                                 { transform.size.x / 2 * transform.scale, transform.size.y / 2 * transform.scale },
-                                 (player_transform.rotation * RAD2DEG) + 90.0f,
-                                 RED);
-            }
-            if (health.show_shield_bar && health.shield > 0)
-            {
-                rlSetLineWidth(Util::lerp(1.0f, 4.0f, health.shield / 100.0f));
-                float radius = (transform.scale * transform.size.x) * Util::lerp(0.75f, 1.0f, health.shield / 100.0f);
-                DrawCircleLines(transform.pos.x - camera.x, transform.pos.y - camera.y, radius, BLUE);
-            }
+            if (world_target.id != 0) UnloadRenderTexture(world_target);
+            world_target = LoadRenderTexture(static_cast<s32>(window_width), static_cast<s32>(window_height));
+            SetTextureFilter(world_target.texture, TEXTURE_FILTER_BILINEAR);
         }
 
+        Camera2D scaled_camera = camera;
+        scaled_camera.offset = { camera.offset.x * resolution_scale, camera.offset.y * resolution_scale };
+        scaled_camera.zoom = camera.zoom * resolution_scale;
+        const CullBounds cull_bounds { player_transform.pos, view_radius, view_radius, view_radius };
 
-        // Draw circle
-        rlSetLineWidth(4);
-        DrawCircleLines(0.0f - camera.x, 0.0f - camera.y, circle_radius, RED);
-
+        BeginTextureMode(world_target);
+        BeginScissorMode(0, 0, static_cast<s32>(std::ceil(window_width * resolution_scale)), static_cast<s32>(std::ceil(window_height * resolution_scale)));
+        ClearBackground(Color{ 15, 15, 15, 255 });
+        BeginMode2D(scaled_camera);
+        render_world(alpha, player_transform, { 0.0f, 0.0f }, cull_bounds, scaled_camera.zoom);
+        EndMode2D();
+        EndScissorMode();
         EndTextureMode();
     }
 
     BeginDrawing();
     {
-        ClearBackground(MAGENTA);
-        float scale = SQRT_2; // make box fit screen
+        if (offscreen_world)
+        {
+            ClearBackground(MAGENTA);
+            float scale = SQRT_2; // make box fit screen
 
 
-        float scale_factor = std::max(window_width, window_height);
+            float scale_factor = std::max(window_width, window_height);
 
-        Rectangle dest = {
-                window_width / 2,
-                window_height  / 2,
-                scale_factor * scale,
-                scale_factor * scale
-        };
+            Rectangle dest = {
+                    window_width / 2,
+                    window_height  / 2,
+                    scale_factor * scale,
+                    scale_factor * scale
+            };
 
-        DrawTexturePro(
-                this->assets.screen.texture,
-                { 0, 0, width, -height },
-                dest,
-                { scale_factor / 2 * scale, scale_factor / 2 * scale },
-                -player_transform.rotation * RAD2DEG - 90.0f,
-                WHITE );
+            // Render textures are upside down, the drawn part is at the bottom
+            const f32 drawn_width = width * offscreen_scale;
+            const f32 drawn_height = height * offscreen_scale;
+
+            {
+                ProfileScope scope(simulation->profiler, "render_blit");
+                DrawTexturePro(
+                        this->assets.screen.texture,
+                        { 0, height - drawn_height, drawn_width, -drawn_height },
+                        dest,
+                        { scale_factor / 2 * scale, scale_factor / 2 * scale },
+                        -player_transform.rotation * RAD2DEG - 90.0f,
+                        WHITE );
+            }
+        }
+        else if (resolution_scale < 1.0f)
+        {
+            const f32 drawn_width = window_width * resolution_scale;
+            const f32 drawn_height = window_height * resolution_scale;
+
+            ProfileScope scope(simulation->profiler, "render_blit");
+            DrawTexturePro(
+                    world_target.texture,
+                    { 0, window_height - drawn_height, drawn_width, -drawn_height },
+                    { 0, 0, window_width, window_height },
+                    { 0, 0 },
+                    0.0f,
+                    WHITE);
+        }
+        else
+        {
+            // Same view as the blit, the camera rotates and scales the world
+            // around the player while it's drawn at window resolution
+            ClearBackground(Color{ 15, 15, 15, 255 });
+            const CullBounds cull_bounds { player_transform.pos, view_radius, view_radius, view_radius };
+
+            BeginMode2D(camera);
+            render_world(alpha, player_transform, { 0.0f, 0.0f }, cull_bounds, camera.zoom);
+            EndMode2D();
+        }
 
 //        DrawText((std::string("x: ") + std::to_string(player_transform.pos.x)).c_str(), 20, window_height - 50, 20, YELLOW);
 //        DrawText((std::string("y: ") + std::to_string(player_transform.pos.y)).c_str(), 20, window_height - 70, 20, YELLOW);
@@ -479,8 +530,8 @@ void Game::render()
 
         // DRAW HUD
 
-        auto& player_component = player.get_component<Component::Player>();
-        auto& player_health = player.get_component<Component::Health>();
+        auto& player_component = simulation->player.get_component<Component::Player>();
+        auto& player_health = simulation->player.get_component<Component::Health>();
 
         const f32 health_bar_width = Util::lerp(0, 200, player_health.health / 100.0f);
         DrawRectangleRounded({20, 20, health_bar_width, 30}, 4, 10,
@@ -492,10 +543,10 @@ void Game::render()
                              player_component.shoot_delay <= 0.1f ? WHITE : DARKGRAY);
         DrawRectangleRoundedLines({window_width - 220, 20, 200, 30}, 4, 10, 4, WHITE);
 
-        DrawText((std::string("Level ") + std::to_string(level_index + 1) + std::string(" / ") + std::to_string(this->assets.levels.size())).c_str(), 30, 70, 32, WHITE);
+        DrawText((std::string("Level ") + std::to_string(simulation->level_index + 1) + std::string(" / ") + std::to_string(this->assets.levels.size())).c_str(), 30, 70, 32, WHITE);
         DrawText((std::string("Score ") + std::to_string(player_component.score)).c_str(), 30, 110, 32, WHITE);
 
-        DrawText((std::string("Bonus Timer: " + std::to_string( (u32) std::floor(bonus_timer)))).c_str(), 30, 150, 32, WHITE);
+        DrawText((std::string("Bonus Timer: " + std::to_string( (u32) std::floor(simulation->bonus_timer)))).c_str(), 30, 150, 32, WHITE);
 
 
         DrawText(projectile_type_to_string(player_component.projectile_type).c_str(),
@@ -532,20 +583,20 @@ void Game::render()
 
 
         // Level fade
-        DrawRectangle(0, 0, window_width, window_height, Color{5, 5, 5, static_cast<u8>(Util::lerp(0, 255, level_fade / 1.0f))});
+        DrawRectangle(0, 0, window_width, window_height, Color{5, 5, 5, static_cast<u8>(Util::lerp(0, 255, simulation->level_fade / 1.0f))});
 
-        if (level_fade >= 1.0f)
+        if (simulation->level_fade >= 1.0f)
         {
-            if (game_over)
+            if (simulation->game_over)
             {
                 render_centered_text("Game Over!", 100, 40, WHITE);
                 render_centered_text(std::string("You'll have to restart your mission").c_str(), window_height / 2 - 16, 32, WHITE);
-                render_centered_text((std::string("You failed on level ") + std::to_string(level_index + 1) + std::string(" with a score of ") + std::to_string(player_component.score)).c_str(), window_height / 2 + 64, 30, WHITE);
+                render_centered_text((std::string("You failed on level ") + std::to_string(simulation->level_index + 1) + std::string(" with a score of ") + std::to_string(player_component.score)).c_str(), window_height / 2 + 64, 30, WHITE);
                 render_centered_text(std::string("Press ENTER to restart!").c_str(), window_height - 132, 32, WHITE);
             }
             else
             {
-                if (game_won)
+                if (simulation->game_won)
                 {
                     render_centered_text("You win! Wait, what?", 100, 40, WHITE);
                     render_centered_text((std::string("Score: ") + std::to_string(player_component.score)).c_str(), window_height / 2 - 16, 32, WHITE);
@@ -554,23 +605,200 @@ void Game::render()
                 else
                 {
                     render_centered_text("Level Complete!", 100, 40, WHITE);
-                    if (bonus_timer > 0.0f)
+                    if (simulation->bonus_timer > 0.0f)
                         render_centered_text((std::string("You earned a score bonus by finishing before the timer!")).c_str(), window_height / 2 - 16 - 64, 30, WHITE);
-                    render_centered_text((std::string("Next level is ") + std::to_string(level_index + 2)).c_str(), window_height / 2 - 16, 32, WHITE);
+                    render_centered_text((std::string("Next level is ") + std::to_string(simulation->level_index + 2)).c_str(), window_height / 2 - 16, 32, WHITE);
                     render_centered_text((std::string("Current score: ") + std::to_string(player_component.score)).c_str(), window_height / 2 + 64, 30, WHITE);
                     render_centered_text(std::string("Press ENTER to continue!").c_str(), window_height - 132, 32, WHITE);
                 }
             }
         }
 
-        if (pause) {
+        if (simulation->pause) {
             DrawRectangle(0, 0, window_width, window_height, Color{50, 50, 50, 200});
             const auto pause_text = "Paused";
             u32 text_height = 42;
             u32 text_width = MeasureText(pause_text, text_height);
             DrawText(pause_text, (window_width - text_width) / 2, (window_height - text_height) / 2, text_height, WHITE);
         }
+
+        if (rewinding)
+        {
+            const u32 seconds = static_cast<u32>(static_cast<f32>(rewind->get_tick_count()) * tick_dt);
+            render_centered_text((std::string("<< Rewind, ") + std::to_string(seconds) + std::string(" s left")).c_str(), 70, 32, WHITE);
+        }
+
+        if (show_profiler) render_profiler();
+    }
+    {
+        // Includes waiting on vsync
+        ProfileScope scope(simulation->profiler, "render_present");
+        EndDrawing();
+    }
+}
+
+void Game::render_world(f32 alpha, const Component::Transform& player_transform, Vector2 camera, const CullBounds& cull_bounds, f32 line_scale)
+{
+    auto& registry = simulation->entity_manager.registry;
+
+    {
+        ProfileScope scope(simulation->profiler, "render_background");
+        background->draw(cull_bounds.center, cull_bounds.half_width, cull_bounds.half_height, camera, GetTime());
+    }
+
+    {
+        ProfileScope scope(simulation->profiler, "render_sprites");
+        // Draw entities
+        sprite_batch->begin();
+        auto view = simulation->entity_manager.registry.view<Component::Transform, Component::Sprite>(entt::exclude<Component::Inactive>);
+        for (auto entity : view)
+        {
+            auto [current_transform, sprite] = view.get<Component::Transform, Component::Sprite>(entity);
+            if (!is_visible(cull_bounds, current_transform.pos, sprite_extent(current_transform))) continue;
+
+            auto transform = interpolate_transform(registry, entity, current_transform, alpha);
+            sprite_batch->draw(sprite.texture,
+                               {static_cast<f32>(sprite.offset_x), static_cast<f32>(sprite.offset_y), transform.size.x, transform.size.y},
+                               {transform.pos.x - camera.x, transform.pos.y - camera.y, transform.size.x * transform.scale, transform.size.y * transform.scale},
+                               {transform.size.x / 2 * transform.scale, transform.size.y / 2 * transform.scale},
+                               (transform.rotation * RAD2DEG) + 90.0f,
+                               sprite.tint);
+        }
+
+        // Effects go on top, in the same batch
+        const auto& particles = simulation->particles.get_buffers();
+        for (u32 i = 0; i < simulation->particles.size(); ++i)
+        {
+            const Vector2 pos { particles.pos_x[i], particles.pos_y[i] };
+            const Vector2 size { particles.size_x[i], particles.size_y[i] };
+            const f32 scale = particles.scale[i];
+            const f32 extent = std::max(size.x, size.y) * scale * static_cast<f32>(SQRT_2) / 2;
+            if (!is_visible(cull_bounds, pos, extent)) continue;
+
+            sprite_batch->draw(&assets.effects,
+                               { particles.frame[i] * size.x, static_cast<f32>(particles.type[i]) * size.y, size.x, size.y },
+                               { pos.x - camera.x, pos.y - camera.y, size.x * scale, size.y * scale },
+                               { size.x / 2 * scale, size.y / 2 * scale },
+                               (particles.rotation[i] * RAD2DEG) + 90.0f,
+                               WHITE);
+        }
+        sprite_batch->end();
+    }
+
+    {
+        ProfileScope scope(simulation->profiler, "render_engines");
+        sprite_batch->begin();
+        auto view2 = simulation->entity_manager.registry.view<Component::Transform, Component::Physics, Component::Sprite>(entt::exclude<Component::Inactive>);
+        for (auto entity : view2)
+        {
+            auto [current_transform, physics, sprite] = view2.get<Component::Transform, Component::Physics, Component::Sprite>(entity);
+            // Flames sit behind the ship, one sprite length further out
+            if (!is_visible(cull_bounds, current_transform.pos, sprite_extent(current_transform) * 2)) continue;
+
+            auto transform = interpolate_transform(registry, entity, current_transform, alpha);
+
+            if (simulation->entity_manager.registry.any_of<Component::Player>(entity))
+            {
+                const f32 magnitude = physics.acc.x * physics.acc.x + physics.acc.y * physics.acc.y;
+                u32 power = std::min((magnitude + 300.0f) / 2300.0f * 4, 4.0f);
+                if (power == 0) continue;
+
+                sprite_batch->draw(&assets.engine,
+                                   { static_cast<float>(power - 1) * transform.size.x, 0, transform.size.x, transform.size.y },
+                                   { transform.pos.x - camera.x, transform.pos.y - camera.y, transform.size.x * transform.scale, transform.size.y * transform.scale },
+                                   { transform.size.x / 2 * transform.scale - 8, - transform.size.y / 2 + 2 },
+                                   (transform.rotation * RAD2DEG) + 90.0f,
+                                   WHITE);
+                sprite_batch->draw(&assets.engine,
+                                   { static_cast<float>(power - 1) * transform.size.x, 0, transform.size.x, transform.size.y },
+                                   { transform.pos.x - camera.x, transform.pos.y - camera.y, transform.size.x * transform.scale, transform.size.y * transform.scale },
+                                   { transform.size.x / 2 * transform.scale + 8, - transform.size.y / 2 + 2 },
+                                   (transform.rotation * RAD2DEG) + 90.0f,
+                                   WHITE);
+            }
+        }
+        sprite_batch->end();
+    }
+
+    {
+        ProfileScope scope(simulation->profiler, "render_markers");
+        // Draw red markers for each enemy
+        auto viewE = simulation->entity_manager.registry.view<Component::Transform, Component::Enemy>();
+        for (auto entity : viewE)
+        {
+            auto [current_transform, enemy] = viewE.get<Component::Transform, Component::Enemy>(entity);
+            auto transform = interpolate_transform(registry, entity, current_transform, alpha);
+            auto distance = Util::distance_between_points(player_transform.pos, transform.pos);
+            if (distance < 2000 && distance > 700)
+            {
+                auto angle = Util::get_angle_between_points(player_transform.pos, transform.pos);
+                auto pos = Util::get_polar_coordinates(angle, 300);
+                DrawCircle(player_transform.pos.x + pos.x - camera.x, player_transform.pos.y + pos.y - camera.y, Util::lerp(1.0f, 4.0f, distance / 2000.0f), RED);
+            }
+        }
+    }
+
+    {
+        ProfileScope scope(simulation->profiler, "render_health");
+        // Draw shield/health bars
+        auto view3 = simulation->entity_manager.registry.view<Component::Transform, Component::Sprite, Component::Health>(entt::exclude<Component::Inactive>);
+        for (auto entity : view3)
+        {
+            auto [current_transform, sprite, health] = view3.get<Component::Transform, Component::Sprite, Component::Health>(entity);
+            if (!is_visible(cull_bounds, current_transform.pos, sprite_extent(current_transform))) continue;
+
+            auto transform = interpolate_transform(registry, entity, current_transform, alpha);
+            if (/*health.show_health_bar*/false && health.health > 0)
+            {
+                Rectangle health_bar_rect = {
+                        transform.pos.x * transform.scale - camera.x,
+                        transform.pos.y * transform.scale - camera.y,
+                        transform.size.x * transform.scale * (health.health / 100.0f),
+                        4
+                };
+                DrawRectanglePro(health_bar_rect,
+                                 { transform.size.x / 2 * transform.scale, transform.size.y / 2 * transform.scale },
+                                 (player_transform.rotation * RAD2DEG) + 90.0f,
+                                 RED);
+            }
+            if (health.show_shield_bar && health.shield > 0)
+            {
+                rlSetLineWidth(Util::lerp(1.0f, 4.0f, health.shield / 100.0f) * line_scale);
+                float radius = (transform.scale * transform.size.x) * Util::lerp(0.75f, 1.0f, health.shield / 100.0f);
+                DrawCircleLines(transform.pos.x - camera.x, transform.pos.y - camera.y, radius, BLUE);
+            }
+        }
+    }
+
+    // Draw circle
+    rlSetLineWidth(4 * line_scale);
+    DrawCircleLines(0.0f - camera.x, 0.0f - camera.y, simulation->circle_radius, RED);
+}
+
+void Game::render_profiler() const
+{
+    const auto stats = simulation->profiler.get_stats();
+
+    const s32 x = 20;
+    const s32 font_size = 16;
+    const s32 line_height = font_size + 4;
+    s32 y = 200;
+    char line[128];
+
+    DrawRectangle(x - 8, y - 8, 460, (static_cast<s32>(stats.size()) + 2) * line_height + 8, Color{0, 0, 0, 180});
+    DrawFPS(x, y);
+    std::snprintf(line, sizeof(line), "world at %u%%", static_cast<u32>(std::lround(resolution.get_scale() * 100.0f)));
+    DrawText(line, x + 120, y, font_size, LIGHTGRAY);
+    y += line_height;
+    DrawText("section                 last     min     avg     p99", x, y, font_size, LIGHTGRAY);
+    y += line_height;
+
+    for (const auto& section : stats)
+    {
+        std::snprintf(line, sizeof(line), "%-22s %6.2f  %6.2f  %6.2f  %6.2f",
+                      section.name, section.last_ms, section.min_ms, section.avg_ms, section.p99_ms);
+        DrawText(line, x, y, font_size, WHITE);
+        y += line_height;
     }
-    EndDrawing();
 }
 
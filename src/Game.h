@@ -2,14 +2,22 @@
 
 #include <types.h>
 #include <Entity.h>
-#include <EntityManager.h>
 #include <Assets.h>
 #include <Loader.h>
-#include <System.h>
+#include <Simulation.h>
+#include <Input.h>
+#include <SpriteBatch.h>
+#include <AssetLoader.h>
+#include <Replay.h>
+#include <RewindBuffer.h>
+#include <ResolutionScaler.h>
+#include <Background.h>
 
 #include <raylib.h>
 #include <vector>
 #include <memory>
+#include <optional>
+#include <string>
 #include "SoundManager.h"
 
 struct GameSpecification
@@ -17,6 +25,49 @@ struct GameSpecification
     u32 width;
     u32 height;
     bool resizable_window;
+
+    // Seed for the simulation's random numbers, random if not set
+    std::optional<u64> seed;
+
+    // Writes the session's seed and input there when the window closes
+    std::string record_file {};
+    // Plays a recorded session back instead of reading the keyboard, its
+    // seed and tick rate override the ones above
+    std::string replay_file {};
+    // Continues from a snapshot instead of starting on the first level,
+    // e.g. from the autosave left behind by a crash
+    std::string resume_file {};
+
+    // Memory for the ticks BACKSPACE steps back through, 0 turns it off
+    size_t rewind_budget { 64 * 1024 * 1024 };
+
+    // Draws the world into the width x height target and blits it rotated
+    // onto the window, instead of drawing it through a rotated camera at
+    // window resolution. Kept for comparison, F4 switches at runtime.
+    bool offscreen_world { false };
+
+    // Share of the full resolution the world is drawn at, lowered while
+    // frames take longer than 1 / target_fps. The HUD always is drawn at
+    // the window's. Equal bounds keep it fixed.
+    f32 min_resolution_scale { 0.5f };
+    f32 max_resolution_scale { 1.0f };
+    f32 target_fps { 60.0f };
+
+    // Simulation ticks per second, independent of the frame rate
+    f32 tick_rate { 120.0f };
+    // Ticks a single slow frame may catch up on before time is dropped
+    u32 max_ticks_per_frame { 8 };
+};
+
+// World space area that can end up on screen. The view is centered on the
+// player and the window only ever shows a circle of it, the offscreen
+// target also cuts it to a square.
+struct CullBounds
+{
+    Vector2 center;
+    f32 half_width;
+    f32 half_height;
+    f32 radius;
 };
 
 class Game
@@ -26,28 +77,62 @@ public:
     void run();
 
 private:
+    // Queues every asset, run() shows the title and progress until they're in
     void load_assets();
-    void setup_level(u32 level_num);
+    void finish_loading();
+    void render_loading() const;
 
-    void update_player(f32 dt);
-    void update(f32 dt);
-    void render();
+    [[nodiscard]] Input poll_input() const;
+    // Recorded input while playing back, the keyboard otherwise
+    void update_simulation();
+    // Snapshots of the simulation, F5 and F9 for the quicksave
+    bool save_snapshot(const std::string& file);
+    bool load_snapshot(const std::string& file);
+    // Neither a recording nor a playback survives the world jumping in time
+    void leave_replay();
+    // alpha is how far between the last two ticks the frame is drawn
+    void render(f32 alpha);
+    // Everything in world space, camera is subtracted from every position
+    // and line widths are scaled to stay the same on screen
+    void render_world(f32 alpha, const Component::Transform& player_transform, Vector2 camera, const CullBounds& cull_bounds, f32 line_scale);
+    // Per section frame times, toggled with F2
+    void render_profiler() const;
 
     Assets assets;
     std::unique_ptr<SoundManager> sound_manger { nullptr };
-    EntityManager entity_manager {};
-    Entity player;
+    std::unique_ptr<Simulation> simulation { nullptr };
+    std::unique_ptr<SpriteBatch> sprite_batch { nullptr };
+    // Made once the star texture is in
+    std::unique_ptr<Background> background { nullptr };
+    // Borrows the simulation's jobs, gone once loading is done
+    std::unique_ptr<AssetLoader> loader { nullptr };
 
-    bool pause { false };
-    bool game_over { false };
-    bool game_won { false };
     bool game_start { false };
+    bool show_profiler { false };
+    bool offscreen_world;
+
+    ResolutionScaler resolution;
+    // Window sized, the world goes through it when drawn below full resolution
+    RenderTexture2D world_target {};
+    // What the offscreen target was last drawn at, a paused frame shows it again
+    f32 offscreen_scale { 1.0f };
+
+    // Fixed timestep
+    f32 tick_dt;
+    u32 max_ticks_per_frame;
+    f32 tick_accumulator { 0.0f };
+    Input pending_input {};
 
-    // Level stuff
+    Replay replay {};
+    std::string record_file;
+    bool playing_back { false };
+    u32 replay_tick { 0 };
 
-    f32 bonus_timer { 0.0f };
+    std::string resume_file;
+    f32 autosave_timer { 0.0f };
+    // Reused by every save
+    std::vector<std::byte> snapshot_bytes {};
 
-    u32 level_index { 0 };
-    f32 circle_radius { 2000 };
-    f32 level_fade { 0 };
+    std::unique_ptr<RewindBuffer> rewind { nullptr };
+    bool rewinding { false };
 };
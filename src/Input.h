@@ -0,0 +1,57 @@
+#pragma once
+
+#include <types.h>
+
+// One bit per player action. Held actions are set for as long as the key
+// is down, the rest only on the tick the key was pressed.
+enum class InputAction : u16
+{
+    THRUST        = 1 << 0,
+    ROTATE_LEFT   = 1 << 1,
+    ROTATE_RIGHT  = 1 << 2,
+    SHOOT         = 1 << 3,
+    SELECT_SHELL  = 1 << 4,
+    SELECT_LASER  = 1 << 5,
+    SELECT_ROCKET = 1 << 6,
+    SELECT_HOMING = 1 << 7,
+    PAUSE         = 1 << 8,
+    SKIP_LEVEL    = 1 << 9,
+    CONFIRM       = 1 << 10
+};
+
+struct Input
+{
+    static constexpr u16 held_actions =
+            static_cast<u16>(InputAction::THRUST) |
+            static_cast<u16>(InputAction::ROTATE_LEFT) |
+            static_cast<u16>(InputAction::ROTATE_RIGHT) |
+            static_cast<u16>(InputAction::SELECT_SHELL) |
+            static_cast<u16>(InputAction::SELECT_LASER) |
+            static_cast<u16>(InputAction::SELECT_ROCKET) |
+            static_cast<u16>(InputAction::SELECT_HOMING);
+
+    u16 actions { 0 };
+
+    [[nodiscard]] bool is_set(InputAction action) const
+    {
+        return (actions & static_cast<u16>(action)) != 0;
+    }
+
+    void set(InputAction action)
+    {
+        actions |= static_cast<u16>(action);
+    }
+
+    // Takes the held actions from the latest poll, but keeps presses that
+    // no simulation tick has seen yet
+    void accumulate(const Input& latest)
+    {
+        actions = (actions & ~held_actions) | latest.actions;
+    }
+
+    // Presses only count for the first tick that sees them
+    void consume_pressed()
+    {
+        actions &= held_actions;
+    }
+};
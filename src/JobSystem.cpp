@@ -0,0 +1,191 @@
+#include <JobSystem.h>
+
+namespace
+{
+    // Which job system the calling thread works for, and as which thread
+    thread_local const JobSystem* current_system = nullptr;
+    thread_local u32 current_index = 0;
+
+    // Ranges pushed at once from a parallel_for, so the queue is locked once per batch
+    constexpr u32 PUSH_BATCH = 64;
+}
+
+JobSystem::JobSystem(u32 worker_count)
+{
+    if (worker_count == 0)
+    {
+        const u32 hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 0;
+    }
+
+    threads.reserve(worker_count + 1);
+    for (u32 i = 0; i < worker_count + 1; ++i)
+    {
+        threads.push_back(std::make_unique<Thread>());
+    }
+
+    workers.reserve(worker_count);
+    for (u32 i = 0; i < worker_count; ++i)
+    {
+        workers.emplace_back([this, i]() { worker_loop(i + 1); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+u32 JobSystem::thread_index() const
+{
+    return current_system == this ? current_index : 0;
+}
+
+void JobSystem::submit(JobCounter& counter, RangeFunction function, void* data, u32 begin, u32 end)
+{
+    const Job job { function, data, begin, end, &counter };
+    push(thread_index(), &job, 1);
+}
+
+void JobSystem::push(u32 index, const Job* jobs, u32 count)
+{
+    // Counted before anyone can take them, so neither count drops below zero
+    jobs[0].counter->pending.fetch_add(count, std::memory_order_relaxed);
+    queued.fetch_add(count, std::memory_order_release);
+
+    {
+        auto& thread = *threads[index];
+        std::lock_guard lock(thread.mutex);
+        thread.jobs.insert(thread.jobs.end(), jobs, jobs + count);
+    }
+
+    if (workers.empty()) return;
+
+    // Taking the lock orders this against a worker checking queued right before going to sleep
+    {
+        std::lock_guard lock(sleep_mutex);
+    }
+    if (count == 1) wake.notify_one();
+    else wake.notify_all();
+}
+
+bool JobSystem::try_run_one(u32 index)
+{
+    Job job {};
+    bool found = false;
+
+    // Newest of our own first, it's the most likely to still be in cache
+    {
+        auto& thread = *threads[index];
+        std::lock_guard lock(thread.mutex);
+        if (!thread.jobs.empty())
+        {
+            job = thread.jobs.back();
+            thread.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // Otherwise the oldest of someone else's
+    for (u32 i = 1; !found && i < threads.size(); ++i)
+    {
+        auto& victim = *threads[(index + i) % threads.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) return false;
+
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    job.function(job.data, job.begin, job.end);
+    job.counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    const u32 index = thread_index();
+    while (!counter.done())
+    {
+        // What's left runs on other threads
+        if (!try_run_one(index)) std::this_thread::yield();
+    }
+}
+
+bool JobSystem::try_run()
+{
+    return try_run_one(thread_index());
+}
+
+void JobSystem::parallel_for(u32 count, u32 grain, RangeFunction function, void* data)
+{
+    if (count == 0) return;
+    grain = std::max(grain, 1u);
+
+    // Nobody to share with, or not enough to share
+    if (workers.empty() || count <= grain)
+    {
+        for (u32 begin = 0; begin < count; begin += grain)
+        {
+            function(data, begin, std::min(begin + grain, count));
+        }
+        return;
+    }
+
+    // All but the first range go to the queue, the first one runs right here
+    JobCounter counter;
+    const u32 index = thread_index();
+
+    Job batch[PUSH_BATCH];
+    u32 batch_size = 0;
+    for (u32 begin = grain; begin < count; begin += grain)
+    {
+        batch[batch_size++] = Job { function, data, begin, std::min(begin + grain, count), &counter };
+        if (batch_size == PUSH_BATCH)
+        {
+            push(index, batch, batch_size);
+            batch_size = 0;
+        }
+    }
+    if (batch_size > 0) push(index, batch, batch_size);
+
+    function(data, 0, std::min(grain, count));
+    wait(counter);
+}
+
+void JobSystem::reset_scratch()
+{
+    for (auto& thread : threads)
+    {
+        thread->scratch.reset();
+    }
+}
+
+void JobSystem::worker_loop(u32 index)
+{
+    current_system = this;
+    current_index = index;
+
+    while (true)
+    {
+        if (try_run_one(index)) continue;
+
+        std::unique_lock lock(sleep_mutex);
+        wake.wait(lock, [&]() { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <types.h>
+#include <ScratchArena.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Counts jobs that haven't finished yet, JobSystem::wait() on it to join them
+class JobCounter
+{
+public:
+    [[nodiscard]] bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<u32> pending { 0 };
+};
+
+// Work-stealing thread pool. Every thread has its own queue, jobs go to the
+// queue of the thread submitting them, which takes the newest one back
+// first, idle threads steal the oldest ones from the others. Threads waiting
+// on a counter run jobs in the meantime, so jobs can fork and join more
+// jobs themselves.
+//
+// The thread that creates the job system is thread 0 and takes part while
+// it waits, no thread outside the pool other than that one may use it.
+// Every thread has a scratch arena, reset_scratch() frees all of them at once.
+class JobSystem
+{
+public:
+    using RangeFunction = void (*)(void* data, u32 begin, u32 end);
+
+    // 0 workers picks one less than the hardware threads
+    explicit JobSystem(u32 worker_count = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Queues function(data, begin, end), data has to stay alive until counter is done
+    void submit(JobCounter& counter, RangeFunction function, void* data, u32 begin = 0, u32 end = 0);
+
+    // Queues func(), it has to stay alive until counter is done
+    template<typename Func>
+    void submit(JobCounter& counter, Func& func)
+    {
+        submit(counter, [](void* data, u32, u32) { (*static_cast<Func*>(data))(); }, &func);
+    }
+
+    // Runs jobs until everything counted by counter finished
+    void wait(JobCounter& counter);
+    // Runs one queued job on the calling thread, false if there was none.
+    // For threads that poll a counter instead of blocking on it.
+    bool try_run();
+
+    // Calls func(begin, end) for [0, count) split into ranges starting at
+    // multiples of grain, spread over the threads, and returns once all of
+    // them ran. Results written per index stay in order no matter which
+    // thread computed them.
+    template<typename Func>
+    void parallel_for(u32 count, u32 grain, Func&& func)
+    {
+        using Function = std::remove_reference_t<Func>;
+        parallel_for(count, grain, [](void* data, u32 begin, u32 end) { (*static_cast<Function*>(data))(begin, end); }, &func);
+    }
+    void parallel_for(u32 count, u32 grain, RangeFunction function, void* data);
+
+    // Calls func(entity, index) for every entity of an EnTT group or view.
+    // For groups index is the position in the group, for views it is the
+    // position in the view's leading storage, entities of that storage the
+    // view skips are left out.
+    template<typename Range, typename Func>
+    void parallel_for_each(Range& range, u32 grain, Func&& func)
+    {
+        using Iterator = decltype(range.begin());
+        if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>)
+        {
+            const auto first = range.begin();
+            parallel_for(static_cast<u32>(range.end() - first), grain, [&](u32 begin, u32 end)
+            {
+                for (u32 i = begin; i < end; ++i) func(first[i], i);
+            });
+        }
+        else
+        {
+            const auto* handle = range.handle();
+            if (handle == nullptr) return;
+
+            const auto first = handle->begin();
+            parallel_for(static_cast<u32>(handle->size()), grain, [&](u32 begin, u32 end)
+            {
+                for (u32 i = begin; i < end; ++i)
+                {
+                    const auto entity = first[i];
+                    if (range.contains(entity)) func(entity, i);
+                }
+            });
+        }
+    }
+
+    // Scratch memory of the calling thread
+    [[nodiscard]] ScratchArena& scratch() { return threads[thread_index()]->scratch; }
+    // Only while no jobs run, everything allocated from any arena is gone afterwards
+    void reset_scratch();
+
+    // Including the creating thread
+    [[nodiscard]] u32 get_thread_count() const { return static_cast<u32>(threads.size()); }
+    [[nodiscard]] u32 thread_index() const;
+
+private:
+    struct Job
+    {
+        RangeFunction function;
+        void* data;
+        u32 begin;
+        u32 end;
+        JobCounter* counter;
+    };
+
+    struct Thread
+    {
+        std::mutex mutex {};
+        std::deque<Job> jobs {};
+        ScratchArena scratch {};
+    };
+
+    void push(u32 index, const Job* jobs, u32 count);
+    bool try_run_one(u32 index);
+    void worker_loop(u32 index);
+
+    std::vector<std::unique_ptr<Thread>> threads {};
+    std::vector<std::thread> workers {};
+
+    // Jobs sitting in any queue, idle workers sleep while there are none
+    std::atomic<u32> queued { 0 };
+    std::mutex sleep_mutex {};
+    std::condition_variable wake {};
+    bool stopping { false };
+};
@@ -1,6 +1,8 @@
 #include "Loader.h"
 
 #include <fstream>
+#include <algorithm>
+#include <iterator>
 #include <json.hpp>
 
 std::optional<std::vector<Level>>
@@ -47,3 +49,38 @@ Loader::load_levels(const std::string& file)
 
     return levels;
 }
+
+std::optional<Texture2D>
+Loader::load_texture_handle(const std::string& file)
+{
+    std::ifstream input_file(file, std::ios::binary);
+
+    if (!input_file.is_open()) {
+        return std::nullopt;
+    }
+
+    // 8 byte signature, then the IHDR chunk: length, type, width, height
+    unsigned char header[24];
+    if (!input_file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        return std::nullopt;
+    }
+
+    const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (!std::equal(std::begin(signature), std::end(signature), header)) {
+        return std::nullopt;
+    }
+
+    auto read_u32_be = [&](u32 offset) {
+        return static_cast<u32>(header[offset]) << 24 |
+               static_cast<u32>(header[offset + 1]) << 16 |
+               static_cast<u32>(header[offset + 2]) << 8 |
+               static_cast<u32>(header[offset + 3]);
+    };
+
+    Texture2D texture {};
+    texture.width = static_cast<int>(read_u32_be(16));
+    texture.height = static_cast<int>(read_u32_be(20));
+    texture.mipmaps = 1;
+    texture.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return texture;
+}
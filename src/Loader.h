@@ -5,8 +5,15 @@
 #include <vector>
 #include <Level.h>
 
+#include <raylib.h>
+
 namespace Loader
 {
     std::optional<std::vector<Level>>
     load_levels(const std::string& file);
+
+    // Reads only the size of a PNG from its header. The returned texture
+    // has no GPU handle and is meant for running without a window.
+    std::optional<Texture2D>
+    load_texture_handle(const std::string& file);
 }
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <types.h>
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The pages are loaded by the OS
+// as they're touched, nothing is copied up front.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Replaces whatever was mapped before, false if the file can't be mapped
+    bool open(const std::string& file);
+    void close();
+
+    [[nodiscard]] bool is_open() const { return data != nullptr; }
+    [[nodiscard]] const std::byte* get_data() const { return data; }
+    [[nodiscard]] size_t get_size() const { return size; }
+
+private:
+    const std::byte* data { nullptr };
+    size_t size { 0 };
+};
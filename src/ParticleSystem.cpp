@@ -0,0 +1,88 @@
+#include <ParticleSystem.h>
+#include <Util.h>
+
+#include <algorithm>
+#include <cmath>
+
+ParticleSystem::ParticleSystem(const Texture2D& texture, u32 capacity)
+    : texture(texture)
+    , max_count(capacity)
+{
+    buffers.pos_x.resize(capacity);
+    buffers.pos_y.resize(capacity);
+    buffers.rotation.resize(capacity);
+    buffers.scale.resize(capacity);
+    buffers.size_x.resize(capacity);
+    buffers.size_y.resize(capacity);
+    buffers.lifetime.resize(capacity);
+    buffers.frame.resize(capacity);
+    buffers.type.resize(capacity);
+}
+
+void ParticleSystem::emit(EffectType type, f32 x, f32 y, f32 lifetime)
+{
+    if (count == max_count) return;
+
+    Vector2 size { 32.0f, 32.0f };
+
+    if (type == EffectType::SPARKS)
+    {
+        size = { Util::random_f32(5.0f, 8.0f), Util::random_f32(5.0f, 8.0f) };
+    }
+
+    const u32 i = count++;
+    buffers.pos_x[i] = x;
+    buffers.pos_y[i] = y;
+    buffers.rotation[i] = Util::random_f32(0.0f, 2.0f * M_PI);
+    buffers.scale[i] = Util::random_f32(0.75f, 1.25f);
+    buffers.size_x[i] = size.x;
+    buffers.size_y[i] = size.y;
+    buffers.lifetime[i] = lifetime;
+    buffers.frame[i] = 0;
+    buffers.type[i] = type;
+}
+
+void ParticleSystem::update(f32 dt)
+{
+    const f32 sheet_width = static_cast<f32>(texture.width);
+
+    u32 i = 0;
+    while (i < count)
+    {
+        buffers.lifetime[i] -= 5.0f * dt;
+
+        if (buffers.lifetime[i] <= 0.0f)
+        {
+            // The last particle moves into this slot, look at it next
+            remove(i);
+            continue;
+        }
+
+        // Animation plays over the last unit of lifetime, longer lived
+        // particles hold the first frame until then
+        const f32 total_frames = std::floor(sheet_width / buffers.size_x[i]);
+        const f32 frame = std::floor((1.0f - buffers.lifetime[i]) * total_frames);
+        buffers.frame[i] = static_cast<u16>(std::clamp(frame, 0.0f, std::max(total_frames - 1.0f, 0.0f)));
+
+        ++i;
+    }
+}
+
+void ParticleSystem::clear()
+{
+    count = 0;
+}
+
+void ParticleSystem::remove(u32 index)
+{
+    const u32 last = --count;
+    buffers.pos_x[index] = buffers.pos_x[last];
+    buffers.pos_y[index] = buffers.pos_y[last];
+    buffers.rotation[index] = buffers.rotation[last];
+    buffers.scale[index] = buffers.scale[last];
+    buffers.size_x[index] = buffers.size_x[last];
+    buffers.size_y[index] = buffers.size_y[last];
+    buffers.lifetime[index] = buffers.lifetime[last];
+    buffers.frame[index] = buffers.frame[last];
+    buffers.type[index] = buffers.type[last];
+}
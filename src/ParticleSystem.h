@@ -0,0 +1,47 @@
+#pragma once
+
+#include <types.h>
+#include <Component.h>
+
+#include <raylib.h>
+#include <vector>
+
+// Fixed capacity pool for short lived effects (explosions, smoke, sparks).
+// Particles are plain structure-of-arrays data instead of registry
+// entities, so spawning and expiring them is a couple of array writes.
+// Emits beyond the capacity are dropped.
+class ParticleSystem
+{
+public:
+    struct Buffers
+    {
+        std::vector<f32> pos_x;
+        std::vector<f32> pos_y;
+        std::vector<f32> rotation;
+        std::vector<f32> scale;
+        std::vector<f32> size_x;
+        std::vector<f32> size_y;
+        std::vector<f32> lifetime;
+        std::vector<u16> frame;
+        std::vector<EffectType> type;
+    };
+
+    explicit ParticleSystem(const Texture2D& texture, u32 capacity = 8192);
+
+    void emit(EffectType type, f32 x, f32 y, f32 lifetime = 1.0f);
+    void update(f32 dt);
+    void clear();
+
+    [[nodiscard]] u32 size() const { return count; }
+    [[nodiscard]] u32 capacity() const { return max_count; }
+    [[nodiscard]] const Buffers& get_buffers() const { return buffers; }
+    [[nodiscard]] const Texture2D& get_texture() const { return texture; }
+
+private:
+    void remove(u32 index);
+
+    const Texture2D& texture;
+    u32 max_count;
+    u32 count { 0 };
+    Buffers buffers;
+};
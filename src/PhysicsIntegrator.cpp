@@ -0,0 +1,233 @@
+#include <PhysicsIntegrator.h>
+
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ASTRALINDA_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Written out once so every backend uses the same rounded value
+    constexpr f32 DECAY = 1.0f - 0.001f;
+
+    // Integrates bodies [first, last). The vector paths below mirror every
+    // operation here, don't let the compiler contract any of them into FMAs.
+    void integrate_scalar(const PhysicsIntegrator::Bodies& b, u32 first, u32 last, f32 dt)
+    {
+        for (u32 i = first; i < last; ++i)
+        {
+            // Decay acceleration
+            b.acc_x[i] -= b.acc_x[i] * DECAY * dt;
+            b.acc_y[i] -= b.acc_y[i] * DECAY * dt;
+
+            // Update velocity based on acceleration
+            b.vel_x[i] += b.acc_x[i] * b.thrust[i] * dt;
+            b.vel_y[i] += b.acc_y[i] * b.thrust[i] * dt;
+
+            // Decay velocity
+            b.vel_x[i] -= b.vel_x[i] * DECAY * dt;
+            b.vel_y[i] -= b.vel_y[i] * DECAY * dt;
+
+            // Update position based on velocity
+            b.pos_x[i] += b.vel_x[i] * dt;
+            b.pos_y[i] += b.vel_y[i] * dt;
+
+            // Cap velocity to a maximum
+            const f32 magnitude = std::sqrt(b.vel_x[i] * b.vel_x[i] + b.vel_y[i] * b.vel_y[i]);
+            if (magnitude > PhysicsIntegrator::max_velocity)
+            {
+                b.vel_x[i] = (b.vel_x[i] / magnitude) * PhysicsIntegrator::max_velocity;
+                b.vel_y[i] = (b.vel_y[i] / magnitude) * PhysicsIntegrator::max_velocity;
+            }
+        }
+    }
+
+#ifdef ASTRALINDA_X86_SIMD
+    __attribute__((target("sse2")))
+    u32 integrate_sse(const PhysicsIntegrator::Bodies& b, u32 count, f32 dt)
+    {
+        const __m128 decay = _mm_set1_ps(DECAY);
+        const __m128 delta = _mm_set1_ps(dt);
+        const __m128 max_velocity = _mm_set1_ps(PhysicsIntegrator::max_velocity);
+
+        u32 i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 acc_x = _mm_loadu_ps(&b.acc_x[i]);
+            __m128 acc_y = _mm_loadu_ps(&b.acc_y[i]);
+            __m128 vel_x = _mm_loadu_ps(&b.vel_x[i]);
+            __m128 vel_y = _mm_loadu_ps(&b.vel_y[i]);
+            __m128 pos_x = _mm_loadu_ps(&b.pos_x[i]);
+            __m128 pos_y = _mm_loadu_ps(&b.pos_y[i]);
+            const __m128 thrust = _mm_loadu_ps(&b.thrust[i]);
+
+            acc_x = _mm_sub_ps(acc_x, _mm_mul_ps(_mm_mul_ps(acc_x, decay), delta));
+            acc_y = _mm_sub_ps(acc_y, _mm_mul_ps(_mm_mul_ps(acc_y, decay), delta));
+
+            vel_x = _mm_add_ps(vel_x, _mm_mul_ps(_mm_mul_ps(acc_x, thrust), delta));
+            vel_y = _mm_add_ps(vel_y, _mm_mul_ps(_mm_mul_ps(acc_y, thrust), delta));
+
+            vel_x = _mm_sub_ps(vel_x, _mm_mul_ps(_mm_mul_ps(vel_x, decay), delta));
+            vel_y = _mm_sub_ps(vel_y, _mm_mul_ps(_mm_mul_ps(vel_y, decay), delta));
+
+            pos_x = _mm_add_ps(pos_x, _mm_mul_ps(vel_x, delta));
+            pos_y = _mm_add_ps(pos_y, _mm_mul_ps(vel_y, delta));
+
+            const __m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vel_x, vel_x), _mm_mul_ps(vel_y, vel_y)));
+            const __m128 over = _mm_cmpgt_ps(magnitude, max_velocity);
+            const __m128 capped_x = _mm_mul_ps(_mm_div_ps(vel_x, magnitude), max_velocity);
+            const __m128 capped_y = _mm_mul_ps(_mm_div_ps(vel_y, magnitude), max_velocity);
+            vel_x = _mm_or_ps(_mm_and_ps(over, capped_x), _mm_andnot_ps(over, vel_x));
+            vel_y = _mm_or_ps(_mm_and_ps(over, capped_y), _mm_andnot_ps(over, vel_y));
+
+            _mm_storeu_ps(&b.acc_x[i], acc_x);
+            _mm_storeu_ps(&b.acc_y[i], acc_y);
+            _mm_storeu_ps(&b.vel_x[i], vel_x);
+            _mm_storeu_ps(&b.vel_y[i], vel_y);
+            _mm_storeu_ps(&b.pos_x[i], pos_x);
+            _mm_storeu_ps(&b.pos_y[i], pos_y);
+        }
+        return i;
+    }
+
+    // No "fma" in the target, fused multiply-adds would round differently
+    __attribute__((target("avx2")))
+    u32 integrate_avx2(const PhysicsIntegrator::Bodies& b, u32 count, f32 dt)
+    {
+        const __m256 decay = _mm256_set1_ps(DECAY);
+        const __m256 delta = _mm256_set1_ps(dt);
+        const __m256 max_velocity = _mm256_set1_ps(PhysicsIntegrator::max_velocity);
+
+        u32 i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 acc_x = _mm256_loadu_ps(&b.acc_x[i]);
+            __m256 acc_y = _mm256_loadu_ps(&b.acc_y[i]);
+            __m256 vel_x = _mm256_loadu_ps(&b.vel_x[i]);
+            __m256 vel_y = _mm256_loadu_ps(&b.vel_y[i]);
+            __m256 pos_x = _mm256_loadu_ps(&b.pos_x[i]);
+            __m256 pos_y = _mm256_loadu_ps(&b.pos_y[i]);
+            const __m256 thrust = _mm256_loadu_ps(&b.thrust[i]);
+
+            acc_x = _mm256_sub_ps(acc_x, _mm256_mul_ps(_mm256_mul_ps(acc_x, decay), delta));
+            acc_y = _mm256_sub_ps(acc_y, _mm256_mul_ps(_mm256_mul_ps(acc_y, decay), delta));
+
+            vel_x = _mm256_add_ps(vel_x, _mm256_mul_ps(_mm256_mul_ps(acc_x, thrust), delta));
+            vel_y = _mm256_add_ps(vel_y, _mm256_mul_ps(_mm256_mul_ps(acc_y, thrust), delta));
+
+            vel_x = _mm256_sub_ps(vel_x, _mm256_mul_ps(_mm256_mul_ps(vel_x, decay), delta));
+            vel_y = _mm256_sub_ps(vel_y, _mm256_mul_ps(_mm256_mul_ps(vel_y, decay), delta));
+
+            pos_x = _mm256_add_ps(pos_x, _mm256_mul_ps(vel_x, delta));
+            pos_y = _mm256_add_ps(pos_y, _mm256_mul_ps(vel_y, delta));
+
+            const __m256 magnitude = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vel_x, vel_x), _mm256_mul_ps(vel_y, vel_y)));
+            const __m256 over = _mm256_cmp_ps(magnitude, max_velocity, _CMP_GT_OQ);
+            vel_x = _mm256_blendv_ps(vel_x, _mm256_mul_ps(_mm256_div_ps(vel_x, magnitude), max_velocity), over);
+            vel_y = _mm256_blendv_ps(vel_y, _mm256_mul_ps(_mm256_div_ps(vel_y, magnitude), max_velocity), over);
+
+            _mm256_storeu_ps(&b.acc_x[i], acc_x);
+            _mm256_storeu_ps(&b.acc_y[i], acc_y);
+            _mm256_storeu_ps(&b.vel_x[i], vel_x);
+            _mm256_storeu_ps(&b.vel_y[i], vel_y);
+            _mm256_storeu_ps(&b.pos_x[i], pos_x);
+            _mm256_storeu_ps(&b.pos_y[i], pos_y);
+        }
+        return i;
+    }
+#endif
+}
+
+PhysicsIntegrator::PhysicsIntegrator()
+{
+    if (is_supported(Backend::AVX2)) backend = Backend::AVX2;
+    else if (is_supported(Backend::SSE)) backend = Backend::SSE;
+}
+
+PhysicsIntegrator::Buffers& PhysicsIntegrator::prepare(u32 count)
+{
+    this->count = count;
+    if (buffers.pos_x.size() < count)
+    {
+        buffers.pos_x.resize(count);
+        buffers.pos_y.resize(count);
+        buffers.vel_x.resize(count);
+        buffers.vel_y.resize(count);
+        buffers.acc_x.resize(count);
+        buffers.acc_y.resize(count);
+        buffers.thrust.resize(count);
+    }
+    return buffers;
+}
+
+void PhysicsIntegrator::integrate(f32 dt)
+{
+    const Bodies bodies {
+        buffers.pos_x.data(),
+        buffers.pos_y.data(),
+        buffers.vel_x.data(),
+        buffers.vel_y.data(),
+        buffers.acc_x.data(),
+        buffers.acc_y.data(),
+        buffers.thrust.data()
+    };
+    integrate(bodies, count, dt);
+}
+
+void PhysicsIntegrator::integrate(const Bodies& bodies, u32 count, f32 dt) const
+{
+    u32 done = 0;
+
+#ifdef ASTRALINDA_X86_SIMD
+    if (backend == Backend::AVX2) done = integrate_avx2(bodies, count, dt);
+    else if (backend == Backend::SSE) done = integrate_sse(bodies, count, dt);
+#endif
+
+    // Whatever doesn't fill a whole vector
+    integrate_scalar(bodies, done, count, dt);
+}
+
+void PhysicsIntegrator::set_backend(Backend backend)
+{
+    if (is_supported(backend))
+    {
+        this->backend = backend;
+    }
+    else if (is_supported(Backend::SSE) && backend == Backend::AVX2)
+    {
+        this->backend = Backend::SSE;
+    }
+    else
+    {
+        this->backend = Backend::SCALAR;
+    }
+}
+
+bool PhysicsIntegrator::is_supported(Backend backend)
+{
+    switch (backend)
+    {
+        case Backend::SCALAR: return true;
+#ifdef ASTRALINDA_X86_SIMD
+        case Backend::SSE:    return __builtin_cpu_supports("sse2");
+        case Backend::AVX2:   return __builtin_cpu_supports("avx2");
+#else
+        case Backend::SSE:    return false;
+        case Backend::AVX2:   return false;
+#endif
+    }
+    return false;
+}
+
+const char* PhysicsIntegrator::backend_name(Backend backend)
+{
+    switch (backend)
+    {
+        case Backend::SCALAR: return "scalar";
+        case Backend::SSE:    return "sse";
+        case Backend::AVX2:   return "avx2";
+    }
+    return "???";
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <types.h>
+
+#include <vector>
+
+// Integrates acceleration, velocity and position of moving bodies over
+// structure-of-arrays buffers. update_physics copies the bodies in and out
+// chunk by chunk, the integration itself runs 4 (SSE) or 8 (AVX2) bodies at a time
+// with the same operations in the same order as the scalar path, so every
+// backend produces bit-identical results.
+class PhysicsIntegrator
+{
+public:
+    enum class Backend : u8
+    {
+        SCALAR = 0,
+        SSE    = 1,
+        AVX2   = 2
+    };
+
+    // Per field arrays of bodies, owned by whoever hands them in
+    struct Bodies
+    {
+        f32* pos_x;
+        f32* pos_y;
+        f32* vel_x;
+        f32* vel_y;
+        f32* acc_x;
+        f32* acc_y;
+        f32* thrust;
+    };
+
+    struct Buffers
+    {
+        std::vector<f32> pos_x;
+        std::vector<f32> pos_y;
+        std::vector<f32> vel_x;
+        std::vector<f32> vel_y;
+        std::vector<f32> acc_x;
+        std::vector<f32> acc_y;
+        std::vector<f32> thrust;
+    };
+
+    static constexpr f32 max_velocity = 200.0f;
+    // Bodies update_physics integrates at once, small enough for the
+    // buffers to stay in L1 between copying in and out
+    static constexpr u32 chunk_size = 256;
+
+    // Picks the widest backend the CPU supports
+    PhysicsIntegrator();
+
+    // Sizes the buffers for count bodies, contents are left to the caller
+    Buffers& prepare(u32 count);
+    void integrate(f32 dt);
+
+    // Integrates count bodies in place, several threads may do so at once
+    void integrate(const Bodies& bodies, u32 count, f32 dt) const;
+
+    [[nodiscard]] u32 size() const { return count; }
+    [[nodiscard]] Buffers& get_buffers() { return buffers; }
+
+    [[nodiscard]] Backend get_backend() const { return backend; }
+    // Falls back to the best supported one if the CPU can't run it
+    void set_backend(Backend backend);
+
+    [[nodiscard]] static bool is_supported(Backend backend);
+    [[nodiscard]] static const char* backend_name(Backend backend);
+
+private:
+    Backend backend { Backend::SCALAR };
+    u32 count { 0 };
+    Buffers buffers;
+};
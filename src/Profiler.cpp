@@ -0,0 +1,109 @@
+#include <Profiler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+    const char* FRAME_SECTION = "frame";
+}
+
+Profiler::Profiler(u32 window_frames)
+    : window_frames(std::max(window_frames, 1u))
+{
+}
+
+void Profiler::begin_frame()
+{
+    frame_start = std::chrono::steady_clock::now();
+    for (auto& section : sections)
+    {
+        section.current_ms = 0.0;
+    }
+}
+
+void Profiler::end_frame()
+{
+    const auto end = std::chrono::steady_clock::now();
+    record(FRAME_SECTION, std::chrono::duration<f64, std::milli>(end - frame_start).count());
+
+    for (auto& section : sections)
+    {
+        section.history[frame_cursor] = static_cast<f32>(section.current_ms);
+    }
+    frame_cursor = (frame_cursor + 1) % window_frames;
+    frame_count = std::min(frame_count + 1, window_frames);
+}
+
+void Profiler::record(const char* name, f64 ms)
+{
+    find_section(name).current_ms += ms;
+}
+
+Profiler::Section& Profiler::find_section(const char* name)
+{
+    for (auto& section : sections)
+    {
+        if (section.name == name) return section;
+    }
+
+    sections.push_back({ name, 0.0, std::vector<f32>(window_frames, 0.0f) });
+    return sections.back();
+}
+
+std::vector<Profiler::SectionStats> Profiler::get_stats() const
+{
+    std::vector<SectionStats> stats;
+    if (frame_count == 0) return stats;
+
+    const u32 last_frame = (frame_cursor + window_frames - 1) % window_frames;
+
+    std::vector<f32> values;
+    for (const auto& section : sections)
+    {
+        values.clear();
+        for (u32 i = 0; i < frame_count; ++i)
+        {
+            values.push_back(section.history[(frame_cursor + window_frames - 1 - i) % window_frames]);
+        }
+
+        f64 sum = 0.0;
+        for (auto value : values) sum += value;
+
+        const u32 p99_index = static_cast<u32>(std::ceil(0.99 * values.size())) - 1;
+        std::nth_element(values.begin(), values.begin() + p99_index, values.end());
+        const f32 p99 = values[p99_index];
+        const f32 min = *std::min_element(values.begin(), values.end());
+
+        stats.push_back({
+            section.name,
+            section.history[last_frame],
+            min,
+            sum / static_cast<f64>(values.size()),
+            p99
+        });
+    }
+    return stats;
+}
+
+bool Profiler::write_csv(const std::string& file) const
+{
+    std::ofstream output(file);
+    if (!output.is_open()) return false;
+
+    output << "index";
+    for (const auto& section : sections) output << ',' << section.name;
+    output << '\n';
+
+    // Oldest frame in the window first
+    const u32 first_frame = (frame_cursor + window_frames - frame_count) % window_frames;
+    for (u32 i = 0; i < frame_count; ++i)
+    {
+        const u32 index = (first_frame + i) % window_frames;
+        output << i;
+        for (const auto& section : sections) output << ',' << section.history[index];
+        output << '\n';
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <types.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Collects how long each named section took per frame over a rolling
+// window of frames. Sections are identified by their name's pointer, so
+// names are expected to be string literals.
+class Profiler
+{
+public:
+    struct SectionStats
+    {
+        const char* name;
+        f64 last_ms;
+        f64 min_ms;
+        f64 avg_ms;
+        f64 p99_ms;
+    };
+
+    explicit Profiler(u32 window_frames = 240);
+
+    void begin_frame();
+    void end_frame();
+
+    // Adds to the section's time for the current frame, sections that run
+    // several times a frame (e.g. one per simulation tick) are summed
+    void record(const char* name, f64 ms);
+
+    [[nodiscard]] std::vector<SectionStats> get_stats() const;
+
+    // One row per frame in the window, one column per section, in ms
+    bool write_csv(const std::string& file) const;
+
+private:
+    struct Section
+    {
+        const char* name;
+        f64 current_ms { 0.0 };
+        std::vector<f32> history;
+    };
+
+    Section& find_section(const char* name);
+
+    u32 window_frames;
+    u32 frame_count { 0 };
+    u32 frame_cursor { 0 };
+    std::chrono::steady_clock::time_point frame_start {};
+    std::vector<Section> sections;
+};
+
+// Records the time between construction and destruction as one section
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler& profiler, const char* name)
+        : profiler(profiler)
+        , name(name)
+        , start(std::chrono::steady_clock::now())
+    {}
+
+    ~ProfileScope()
+    {
+        const auto end = std::chrono::steady_clock::now();
+        profiler.record(name, std::chrono::duration<f64, std::milli>(end - start).count());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler& profiler;
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+};
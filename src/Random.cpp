@@ -0,0 +1,42 @@
+#include <Random.h>
+
+#include <random>
+
+namespace
+{
+    struct ThreadGenerator
+    {
+        ThreadGenerator()
+        {
+            std::random_device rd {};
+            seed = (static_cast<u64>(rd()) << 32u) | rd();
+            engine.reseed(seed, 0);
+        }
+
+        Random::Pcg32 engine;
+        u64 seed { 0 };
+    };
+
+    ThreadGenerator& thread_generator()
+    {
+        thread_local ThreadGenerator generator {};
+        return generator;
+    }
+}
+
+Random::Pcg32& Random::engine()
+{
+    return thread_generator().engine;
+}
+
+void Random::seed(u64 seed, u64 stream)
+{
+    auto& generator = thread_generator();
+    generator.seed = seed;
+    generator.engine.reseed(seed, stream);
+}
+
+u64 Random::current_seed()
+{
+    return thread_generator().seed;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <types.h>
+
+#include <limits>
+
+namespace Random
+{
+    // PCG32 (XSH-RR). 16 bytes of state, so it is cheap to keep one per
+    // thread and to copy around. Each stream selects a distinct sequence
+    // for the same seed. Satisfies UniformRandomBitGenerator, so it can be
+    // handed to std::shuffle and friends.
+    class Pcg32
+    {
+    public:
+        using result_type = u32;
+
+        Pcg32() : Pcg32(0x853c49e6748fea9bULL, 0xda3e39cb94b95bdbULL) {}
+        Pcg32(u64 seed, u64 stream) { reseed(seed, stream); }
+
+        void reseed(u64 seed, u64 stream)
+        {
+            state = 0;
+            increment = (stream << 1u) | 1u;
+            next();
+            state += seed;
+            next();
+        }
+
+        u32 next()
+        {
+            u64 old_state = state;
+            state = old_state * 6364136223846793005ULL + increment;
+            u32 xorshifted = static_cast<u32>(((old_state >> 18u) ^ old_state) >> 27u);
+            u32 rot = static_cast<u32>(old_state >> 59u);
+            return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+        }
+
+        // Unbiased integer in [0, range), Lemire's multiply-and-reject
+        u32 next_bounded(u32 range)
+        {
+            u64 m = static_cast<u64>(next()) * range;
+            u32 low = static_cast<u32>(m);
+            if (low < range)
+            {
+                u32 threshold = (0u - range) % range;
+                while (low < threshold)
+                {
+                    m = static_cast<u64>(next()) * range;
+                    low = static_cast<u32>(m);
+                }
+            }
+            return static_cast<u32>(m >> 32u);
+        }
+
+        // Float in [0, 1) using the top 24 bits
+        f32 next_f32()
+        {
+            return static_cast<f32>(next() >> 8u) * (1.0f / 16777216.0f);
+        }
+
+        result_type operator()() { return next(); }
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<u32>::max(); }
+
+    private:
+        u64 state { 0 };
+        u64 increment { 0 };
+    };
+
+    // The calling thread's generator. Unseeded threads start from a
+    // std::random_device seed the first time they ask for it.
+    Pcg32& engine();
+
+    // Reseed the calling thread's generator, making everything drawn from
+    // Util::random_* afterwards reproducible.
+    void seed(u64 seed, u64 stream = 0);
+
+    // Seed the calling thread was last seeded with
+    u64 current_seed();
+}
@@ -0,0 +1,118 @@
+#include <Replay.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    constexpr char MAGIC[8] = { 'A', 'S', 'T', 'R', 'R', 'P', 'L', 'Y' };
+    // Bumped whenever the simulation draws its random numbers differently,
+    // older recordings would play out another way
+    constexpr u32 VERSION = 2;
+
+    struct Header
+    {
+        char magic[8];
+        u32 version;
+        u32 tick_count;
+        u64 seed;
+        f32 tick_dt;
+        u32 run_count;
+        u32 death_distance_count;
+        u32 reserved;
+    };
+
+    // Input mostly stays the same for many ticks in a row, runs over 65535 ticks are split
+    struct Run
+    {
+        u16 actions;
+        u16 length;
+    };
+
+    template<typename T>
+    bool read_values(std::ifstream& input, T* values, size_t count)
+    {
+        return static_cast<bool>(input.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(count * sizeof(T))));
+    }
+
+    template<typename T>
+    void write_values(std::ofstream& output, const T* values, size_t count)
+    {
+        output.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(T)));
+    }
+}
+
+void Replay::record(const Input& input, f32 death_distance)
+{
+    if (death_distances.empty() || death_distances.back().distance != death_distance)
+    {
+        death_distances.push_back({ get_tick_count(), death_distance });
+    }
+    actions.push_back(input.actions);
+}
+
+std::optional<f32> Replay::get_death_distance(u32 tick) const
+{
+    // Last change at or before the tick
+    const auto next = std::upper_bound(death_distances.begin(), death_distances.end(), tick,
+                                       [](u32 value, const DeathDistance& change) { return value < change.tick; });
+    if (next == death_distances.begin()) return std::nullopt;
+    return std::prev(next)->distance;
+}
+
+bool Replay::write(const std::string& file) const
+{
+    std::vector<Run> runs;
+    for (const u16 tick_actions : actions)
+    {
+        if (!runs.empty() && runs.back().actions == tick_actions && runs.back().length < UINT16_MAX) runs.back().length += 1;
+        else runs.push_back({ tick_actions, 1 });
+    }
+
+    Header header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.tick_count = get_tick_count();
+    header.seed = seed;
+    header.tick_dt = tick_dt;
+    header.run_count = static_cast<u32>(runs.size());
+    header.death_distance_count = static_cast<u32>(death_distances.size());
+
+    std::ofstream output(file, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) return false;
+
+    write_values(output, &header, 1);
+    write_values(output, runs.data(), runs.size());
+    write_values(output, death_distances.data(), death_distances.size());
+    return static_cast<bool>(output);
+}
+
+std::optional<Replay> Replay::read(const std::string& file)
+{
+    std::ifstream input(file, std::ios::binary);
+    if (!input.is_open()) return std::nullopt;
+
+    Header header {};
+    if (!read_values(input, &header, 1)) return std::nullopt;
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) return std::nullopt;
+
+    std::vector<Run> runs(header.run_count);
+    std::vector<DeathDistance> death_distances(header.death_distance_count);
+    if (!read_values(input, runs.data(), runs.size())) return std::nullopt;
+    if (!read_values(input, death_distances.data(), death_distances.size())) return std::nullopt;
+
+    Replay replay;
+    replay.seed = header.seed;
+    replay.tick_dt = header.tick_dt;
+    replay.death_distances = std::move(death_distances);
+    replay.actions.reserve(header.tick_count);
+    for (const auto& run : runs)
+    {
+        if (run.length > header.tick_count - replay.actions.size()) return std::nullopt;
+        replay.actions.insert(replay.actions.end(), run.length, run.actions);
+    }
+    if (replay.actions.size() != header.tick_count) return std::nullopt;
+
+    return replay;
+}
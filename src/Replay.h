@@ -0,0 +1,41 @@
+#pragma once
+
+#include <types.h>
+#include <Input.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// Everything a session depends on besides the code: the seed, the fixed
+// tick length and the input of every tick. Seeding the simulation the same
+// way and feeding the ticks back in reproduces the session exactly,
+// whatever the frame rate or thread count.
+//
+// On disk, little endian: a header, the input as runs of identical ticks,
+// then every change of the death distance, which follows the window size.
+struct Replay
+{
+    struct DeathDistance
+    {
+        // First tick using it
+        u32 tick;
+        f32 distance;
+    };
+
+    u64 seed { 0 };
+    f32 tick_dt { 1.0f / 120.0f };
+    std::vector<u16> actions {};
+    std::vector<DeathDistance> death_distances {};
+
+    // Appends one tick
+    void record(const Input& input, f32 death_distance);
+
+    [[nodiscard]] u32 get_tick_count() const { return static_cast<u32>(actions.size()); }
+    [[nodiscard]] Input get_input(u32 tick) const { return Input { actions[tick] }; }
+    // Nothing before the first recorded tick, the simulation keeps its own then
+    [[nodiscard]] std::optional<f32> get_death_distance(u32 tick) const;
+
+    [[nodiscard]] bool write(const std::string& file) const;
+    [[nodiscard]] static std::optional<Replay> read(const std::string& file);
+};
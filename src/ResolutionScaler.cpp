@@ -0,0 +1,62 @@
+#include <ResolutionScaler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    // Scales are kept to multiples of this, small changes aren't worth a new window
+    constexpr f32 STEP = 0.05f;
+    // Over the target by this much before going down, under it by this much
+    // before going up, so a scale right at the edge doesn't flip back and forth
+    constexpr f32 DOWN_THRESHOLD = 1.05f;
+    constexpr f32 UP_THRESHOLD = 0.8f;
+}
+
+ResolutionScaler::ResolutionScaler(f32 min_scale, f32 max_scale, f32 target_frame_time, u32 window_frames)
+    : min_scale(std::min(min_scale, max_scale))
+    , max_scale(max_scale)
+    , target_frame_time(target_frame_time)
+    , frame_times(std::max(window_frames, 1u), 0.0f)
+    , scale(max_scale)
+{
+}
+
+void ResolutionScaler::add_frame(f32 frame_time)
+{
+    const u32 window_frames = static_cast<u32>(frame_times.size());
+    frame_times[cursor] = frame_time;
+    cursor = (cursor + 1) % window_frames;
+    frame_count = std::min(frame_count + 1, window_frames);
+    if (frame_count < window_frames) return;
+
+    const f32 average = std::accumulate(frame_times.begin(), frame_times.end(), 0.0f) / static_cast<f32>(window_frames);
+
+    f32 next = scale;
+    if (average > target_frame_time * DOWN_THRESHOLD)
+    {
+        // The pixel count goes with the square of the scale, assume the
+        // whole frame does too and go straight to where it would fit
+        const f32 fitting = scale * std::sqrt(target_frame_time / average);
+        next = std::min(std::floor(fitting / STEP) * STEP, scale - STEP);
+    }
+    else if (average < target_frame_time * UP_THRESHOLD)
+    {
+        // Up one step at a time, the frames at the new scale tell if there's more room
+        next = scale + STEP;
+    }
+
+    next = std::clamp(next, min_scale, max_scale);
+    if (next != scale)
+    {
+        scale = next;
+        reset();
+    }
+}
+
+void ResolutionScaler::reset()
+{
+    cursor = 0;
+    frame_count = 0;
+}
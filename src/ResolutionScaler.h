@@ -0,0 +1,36 @@
+#pragma once
+
+#include <types.h>
+
+#include <vector>
+
+// Picks the share of the full resolution the world is drawn at from how
+// long the last frames took. Once a window of frames averages over the
+// target frame time the scale goes down, well under it goes back up, always
+// between the bounds. Nothing limits the frame rate and presenting waits on
+// the GPU when it falls behind, so the frame time covers both.
+//
+// The window starts over after every change, so the next decision only
+// sees frames drawn at the new scale.
+class ResolutionScaler
+{
+public:
+    ResolutionScaler(f32 min_scale, f32 max_scale, f32 target_frame_time, u32 window_frames = 30);
+
+    // Seconds the last frame took
+    void add_frame(f32 frame_time);
+    // Forgets the frames so far, e.g. after a hitch that isn't the renderer's
+    void reset();
+
+    [[nodiscard]] f32 get_scale() const { return scale; }
+
+private:
+    f32 min_scale;
+    f32 max_scale;
+    f32 target_frame_time;
+
+    std::vector<f32> frame_times;
+    u32 cursor { 0 };
+    u32 frame_count { 0 };
+    f32 scale;
+};
@@ -0,0 +1,274 @@
+#include <RewindBuffer.h>
+#include <Component.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+    // Tracked components are compared and stored as 4 byte words, one bit of
+    // the mask per word that changed
+    using Mask = u16;
+
+    template<typename T>
+    constexpr u32 word_count()
+    {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(u32) == 0, "Tracked components have to be made of words");
+        static_assert(sizeof(T) / sizeof(u32) <= sizeof(Mask) * 8, "Too many words for the mask");
+        return sizeof(T) / sizeof(u32);
+    }
+
+    // Calls function with a value of every tracked component type and its base index
+    template<typename Function>
+    void for_each_tracked(Function&& function)
+    {
+        function(Component::Transform {}, 0);
+        function(Component::Physics {}, 1);
+        function(Component::Health {}, 2);
+        function(Component::Enemy {}, 3);
+        function(Component::Player {}, 4);
+    }
+
+    template<typename T>
+    void append(std::vector<std::byte>& bytes, const T& value)
+    {
+        const auto* first = reinterpret_cast<const std::byte*>(&value);
+        bytes.insert(bytes.end(), first, first + sizeof(T));
+    }
+
+    template<typename T>
+    T read(const std::vector<std::byte>& bytes, size_t& offset)
+    {
+        T value;
+        std::memcpy(&value, &bytes[offset], sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+}
+
+RewindBuffer::RewindBuffer(size_t memory_budget, u32 keyframe_interval)
+    : memory_budget(memory_budget)
+    , keyframe_interval(std::max(keyframe_interval, 1u))
+{
+}
+
+void RewindBuffer::record(Simulation& simulation)
+{
+    Frame frame { false, {} };
+    if (needs_keyframe || ticks_since_keyframe >= keyframe_interval || static_cast<entt::entity>(simulation.player) != keyframe_player)
+    {
+        record_keyframe(simulation, frame);
+    }
+    else
+    {
+        record_delta(simulation, frame);
+    }
+    ticks_since_keyframe += 1;
+
+    memory_used += frame.bytes.capacity();
+    frames.push_back(std::move(frame));
+    trim();
+}
+
+bool RewindBuffer::step_back(Simulation& simulation)
+{
+    if (frames.size() < 2) return false;
+
+    memory_used -= frames.back().bytes.capacity();
+    frames.pop_back();
+    restore(simulation);
+
+    // What's recorded from here on is another timeline, it starts over
+    // from a keyframe of its own
+    needs_keyframe = true;
+    return true;
+}
+
+void RewindBuffer::resume(Simulation& simulation)
+{
+    if (frames.empty()) return;
+
+    while (!frames.back().keyframe)
+    {
+        memory_used -= frames.back().bytes.capacity();
+        frames.pop_back();
+    }
+    simulation.load_snapshot(frames.back().bytes);
+    simulation.store_previous_transforms();
+    needs_keyframe = true;
+}
+
+void RewindBuffer::clear()
+{
+    frames.clear();
+    memory_used = 0;
+    needs_keyframe = true;
+}
+
+void RewindBuffer::record_keyframe(Simulation& simulation, Frame& frame)
+{
+    frame.keyframe = true;
+    simulation.save_snapshot(frame.bytes);
+
+    auto& registry = simulation.entity_manager.registry;
+    keyframe_player = simulation.player;
+    keyframe_entities.clear();
+    for (auto entity : registry.view<Component::Transform>(entt::exclude<Component::Inactive>))
+    {
+        keyframe_entities.push_back(entity);
+    }
+
+    for_each_tracked([&](auto component, u32 index) {
+        save_base<decltype(component)>(registry, bases[index]);
+    });
+
+    ticks_since_keyframe = 0;
+    needs_keyframe = false;
+}
+
+void RewindBuffer::record_delta(Simulation& simulation, Frame& frame)
+{
+    auto& registry = simulation.entity_manager.registry;
+
+    // Destroyed or back in the projectile pool since the keyframe
+    const size_t count_offset = frame.bytes.size();
+    append(frame.bytes, u32 { 0 });
+    u32 count = 0;
+    for (const auto entity : keyframe_entities)
+    {
+        if (registry.valid(entity) && !registry.all_of<Component::Inactive>(entity)) continue;
+        append(frame.bytes, entity);
+        ++count;
+    }
+    std::memcpy(&frame.bytes[count_offset], &count, sizeof(count));
+
+    for_each_tracked([&](auto component, u32 index) {
+        write_changes<decltype(component)>(registry, bases[index], frame.bytes);
+    });
+}
+
+void RewindBuffer::restore(Simulation& simulation)
+{
+    // The oldest frame always is a keyframe
+    auto keyframe = frames.end() - 1;
+    while (!keyframe->keyframe) --keyframe;
+    simulation.load_snapshot(keyframe->bytes);
+
+    const auto& frame = frames.back();
+    if (!frame.keyframe)
+    {
+        auto& registry = simulation.entity_manager.registry;
+
+        size_t offset = 0;
+        const auto count = read<u32>(frame.bytes, offset);
+        for (u32 i = 0; i < count; ++i)
+        {
+            const Entity entity(read<entt::entity>(frame.bytes, offset), &registry);
+            if (entity.has_component<Component::Projectile>()) simulation.entity_manager.release_projectile(entity);
+            else registry.destroy(entity);
+        }
+
+        for_each_tracked([&](auto component, u32) {
+            offset = apply_changes<decltype(component)>(registry, frame.bytes, offset);
+        });
+    }
+
+    simulation.store_previous_transforms();
+}
+
+void RewindBuffer::trim()
+{
+    // Whole keyframes go at once, never the newest one
+    while (memory_used > memory_budget)
+    {
+        size_t frame_count = 1;
+        while (frame_count < frames.size() && !frames[frame_count].keyframe) ++frame_count;
+        if (frame_count == frames.size()) break;
+
+        for (; frame_count > 0; --frame_count)
+        {
+            memory_used -= frames.front().bytes.capacity();
+            frames.pop_front();
+        }
+    }
+}
+
+template<typename T>
+void RewindBuffer::save_base(entt::registry& registry, Base& base)
+{
+    constexpr u32 words = word_count<T>();
+    const size_t capacity = registry.storage<entt::entity>().size();
+    base.words.resize(capacity * words);
+    base.present.assign(capacity, 0);
+
+    for (auto [entity, component] : registry.storage<T>().each())
+    {
+        const auto index = entt::to_entity(entity);
+        std::memcpy(&base.words[index * words], &component, sizeof(T));
+        base.present[index] = 1;
+    }
+}
+
+template<typename T>
+void RewindBuffer::write_changes(entt::registry& registry, const Base& base, std::vector<std::byte>& bytes)
+{
+    constexpr u32 words = word_count<T>();
+
+    const size_t count_offset = bytes.size();
+    append(bytes, u32 { 0 });
+    u32 count = 0;
+
+    // Components added since the keyframe have nothing to go on when restoring
+    for (auto [entity, component] : registry.storage<T>().each())
+    {
+        const auto index = entt::to_entity(entity);
+        if (index >= base.present.size() || base.present[index] == 0) continue;
+
+        u32 current[words];
+        std::memcpy(current, &component, sizeof(T));
+        const u32* saved = &base.words[index * words];
+
+        Mask mask = 0;
+        for (u32 i = 0; i < words; ++i)
+        {
+            if (current[i] != saved[i]) mask |= static_cast<Mask>(1u << i);
+        }
+        if (mask == 0) continue;
+
+        append(bytes, entity);
+        append(bytes, mask);
+        for (u32 i = 0; i < words; ++i)
+        {
+            if (mask & (1u << i)) append(bytes, current[i]);
+        }
+        ++count;
+    }
+
+    std::memcpy(&bytes[count_offset], &count, sizeof(count));
+}
+
+template<typename T>
+size_t RewindBuffer::apply_changes(entt::registry& registry, const std::vector<std::byte>& bytes, size_t offset)
+{
+    constexpr u32 words = word_count<T>();
+    auto& storage = registry.storage<T>();
+
+    const auto count = read<u32>(bytes, offset);
+    for (u32 n = 0; n < count; ++n)
+    {
+        const auto entity = read<entt::entity>(bytes, offset);
+        const auto mask = read<Mask>(bytes, offset);
+
+        // Entities recycled since the keyframe aren't in it, their changes are skipped
+        T* component = storage.contains(entity) ? &storage.get(entity) : nullptr;
+        u32 current[words] {};
+        if (component != nullptr) std::memcpy(current, component, sizeof(T));
+        for (u32 i = 0; i < words; ++i)
+        {
+            if (mask & (1u << i)) current[i] = read<u32>(bytes, offset);
+        }
+        if (component != nullptr) std::memcpy(component, current, sizeof(T));
+    }
+    return offset;
+}
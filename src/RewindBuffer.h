@@ -0,0 +1,81 @@
+#pragma once
+
+#include <types.h>
+#include <Simulation.h>
+
+#include <entt/entt.hpp>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+// The last moments of a session, to step back through tick by tick. Every
+// keyframe_interval ticks a whole simulation snapshot is kept, the ticks in
+// between only store the Transform, Physics, Health, Enemy and Player fields
+// that differ from the keyframe and which of its entities are gone. The
+// oldest keyframes are dropped to stay within the memory budget.
+//
+// Stepping back loads the keyframe and applies the tick on top of it. That
+// is close enough to watch but not to play on from: entities created after
+// the keyframe are missing, and the random generator and level timers are
+// the keyframe's. Once rewinding stops, resume() goes back to the keyframe
+// itself, the newest tick that continues exactly like it did the first time.
+class RewindBuffer
+{
+public:
+    explicit RewindBuffer(size_t memory_budget, u32 keyframe_interval = 60);
+
+    // After every tick
+    void record(Simulation& simulation);
+    // Goes back one tick, dropping the newer ones. False once there is
+    // nothing older left.
+    bool step_back(Simulation& simulation);
+    // Drops the ticks after the newest keyframe and loads it, before
+    // recording goes on from a rewound tick
+    void resume(Simulation& simulation);
+    void clear();
+
+    [[nodiscard]] u32 get_tick_count() const { return static_cast<u32>(frames.size()); }
+    [[nodiscard]] size_t get_memory_used() const { return memory_used; }
+
+private:
+    struct Frame
+    {
+        bool keyframe;
+        std::vector<std::byte> bytes;
+    };
+
+    // Keyframe values of one tracked component type as words, indexed by entity
+    struct Base
+    {
+        std::vector<u32> words {};
+        std::vector<u8> present {};
+    };
+
+    void record_keyframe(Simulation& simulation, Frame& frame);
+    void record_delta(Simulation& simulation, Frame& frame);
+    // Loads the newest frame into the simulation
+    void restore(Simulation& simulation);
+    void trim();
+
+    template<typename T>
+    void save_base(entt::registry& registry, Base& base);
+    template<typename T>
+    void write_changes(entt::registry& registry, const Base& base, std::vector<std::byte>& bytes);
+    template<typename T>
+    size_t apply_changes(entt::registry& registry, const std::vector<std::byte>& bytes, size_t offset);
+
+    size_t memory_budget;
+    u32 keyframe_interval;
+
+    std::deque<Frame> frames {};
+    size_t memory_used { 0 };
+
+    u32 ticks_since_keyframe { 0 };
+    bool needs_keyframe { true };
+    // A new player means the level was set up again, which needs a keyframe
+    entt::entity keyframe_player { entt::null };
+    // Active entities of the keyframe, the ones that can go missing
+    std::vector<entt::entity> keyframe_entities {};
+    std::array<Base, 5> bases {};
+};
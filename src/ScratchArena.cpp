@@ -0,0 +1,47 @@
+#include <ScratchArena.h>
+
+#include <algorithm>
+#include <cstdint>
+
+ScratchArena::ScratchArena(size_t block_size)
+    : block_size(block_size)
+{
+}
+
+void* ScratchArena::allocate_bytes(size_t size, size_t alignment)
+{
+    while (current < blocks.size())
+    {
+        auto& block = blocks[current];
+        const auto address = reinterpret_cast<std::uintptr_t>(block.data.get()) + offset;
+        const size_t padding = (alignment - address % alignment) % alignment;
+
+        if (offset + padding + size <= block.size)
+        {
+            offset += padding + size;
+            return reinterpret_cast<void*>(address + padding);
+        }
+
+        // Doesn't fit, the rest of this block stays unused until the reset
+        used_before_current += offset;
+        offset = 0;
+        current += 1;
+    }
+
+    // Oversized requests get a block of their own
+    const size_t size_with_padding = size + alignment;
+    blocks.push_back(Block { std::make_unique<std::byte[]>(std::max(block_size, size_with_padding)), std::max(block_size, size_with_padding) });
+    return allocate_bytes(size, alignment);
+}
+
+void ScratchArena::reset()
+{
+    current = 0;
+    offset = 0;
+    used_before_current = 0;
+}
+
+size_t ScratchArena::get_used() const
+{
+    return used_before_current + offset;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <types.h>
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for memory that only lives until the next reset, e.g. one
+// tick. Allocations aren't freed one by one, reset() drops all of them at
+// once and keeps the blocks around for the next round. Nothing is
+// constructed or destroyed, the memory comes back uninitialized.
+class ScratchArena
+{
+public:
+    explicit ScratchArena(size_t block_size = 64 * 1024);
+
+    template<typename T>
+    T* allocate(size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "Scratch memory is never constructed nor destroyed");
+        return static_cast<T*>(allocate_bytes(count * sizeof(T), alignof(T)));
+    }
+
+    void reset();
+
+    // Bytes handed out since the last reset, alignment padding included
+    [[nodiscard]] size_t get_used() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    void* allocate_bytes(size_t size, size_t alignment);
+
+    size_t block_size;
+    std::vector<Block> blocks {};
+    u32 current { 0 };
+    size_t offset { 0 };
+    size_t used_before_current { 0 };
+};
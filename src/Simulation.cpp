@@ -0,0 +1,448 @@
+#include <Simulation.h>
+#include <Component.h>
+#include <Util.h>
+#include <System.h>
+#include <Snapshot.h>
+#include <Random.h>
+
+#include <cmath>
+#include <cstring>
+
+#define PI2 (2 * PI)
+
+namespace
+{
+    // One literal, the profiler tells sections apart by pointer
+    constexpr const char* FLUSH_COMMANDS = "flush_commands";
+
+    constexpr char SNAPSHOT_MAGIC[8] = { 'A', 'S', 'T', 'R', 'S', 'A', 'V', 'E' };
+
+    // Sync point, applies the structural changes recorded by the systems before it
+    void flush_commands(SystemContext& context, f32 dt)
+    {
+        context.commands.flush(context.entity_manager);
+    }
+}
+
+Simulation::Simulation(Assets& assets, SoundManager& sound_manager, u32 worker_count)
+    : particles(assets.effects)
+    , jobs(worker_count)
+    , scheduler(jobs)
+    , assets(assets)
+    , sound_manager(sound_manager)
+{
+    setup_systems();
+}
+
+void Simulation::setup_systems()
+{
+    // Systems run in the order they are added wherever their access overlaps.
+    // Structural changes are applied at the sync points, between them storages
+    // don't change under the iteration.
+
+    scheduler.add("update_enemy_index", System::update_enemy_index)
+        .reads<Component::Transform, Component::Enemy>()
+        .writes(Resource::ENEMY_INDEX);
+
+    scheduler.add("update_projectiles", System::update_projectiles)
+        .reads<Component::Player, Component::Inactive>()
+        .reads(Resource::ENEMY_INDEX)
+        .writes<Component::Projectile, Component::Transform, Component::Physics>()
+        .writes(Resource::COMMANDS);
+
+    scheduler.add("update_enemies", System::update_enemies)
+        .writes<Component::Transform, Component::Physics, Component::Enemy>()
+        .writes(Resource::RANDOM)
+        .writes(Resource::SOUND)
+        .writes(Resource::COMMANDS);
+
+    scheduler.add(FLUSH_COMMANDS, flush_commands).sync();
+
+    scheduler.add("update_physics", System::update_physics)
+        .writes<Component::Transform, Component::Physics>()
+        .writes(Resource::INTEGRATOR);
+
+    scheduler.add("update_broadphase", System::update_broadphase)
+        .reads<Component::Transform, Component::CircleCollider, Component::Inactive>()
+        .writes(Resource::BROADPHASE);
+
+    scheduler.add("update_effects", System::update_effects)
+        .writes(Resource::PARTICLES);
+
+    scheduler.add("update_projectile_collisions", System::update_projectile_collisions)
+        .reads<Component::Transform, Component::CircleCollider, Component::Projectile, Component::Enemy, Component::Inactive>()
+        .reads(Resource::BROADPHASE)
+        .writes<Component::Health, Component::Player>()
+        .writes(Resource::RANDOM)
+        .writes(Resource::SOUND)
+        .writes(Resource::PARTICLES)
+        .writes(Resource::COMMANDS)
+        .writes(Resource::GAME_STATE);
+
+    scheduler.add("update_player_enemy_collisions", System::update_player_enemy_collisions)
+        .reads<Component::Transform, Component::Physics, Component::CircleCollider, Component::Projectile, Component::Enemy, Component::Inactive>()
+        .reads(Resource::BROADPHASE)
+        .writes<Component::Health, Component::Player>()
+        .writes(Resource::RANDOM)
+        .writes(Resource::SOUND)
+        .writes(Resource::PARTICLES)
+        .writes(Resource::COMMANDS)
+        .writes(Resource::GAME_STATE);
+
+    scheduler.add("update_player_pickup_collisions", System::update_player_pickup_collisions)
+        .reads<Component::Transform, Component::CircleCollider, Component::Pickup, Component::Inactive>()
+        .reads(Resource::BROADPHASE)
+        .writes<Component::Physics, Component::Health, Component::Player>()
+        .writes(Resource::COMMANDS);
+
+    scheduler.add("update_health_circle_radius", System::update_health_circle_radius)
+        .reads<Component::Transform, Component::Projectile, Component::Enemy, Component::Inactive>()
+        .writes<Component::Health, Component::Player>()
+        .writes(Resource::RANDOM)
+        .writes(Resource::SOUND)
+        .writes(Resource::PARTICLES)
+        .writes(Resource::COMMANDS)
+        .writes(Resource::GAME_STATE);
+
+    scheduler.add(FLUSH_COMMANDS, flush_commands).sync();
+
+    scheduler.add("update_pickups", System::update_pickups)
+        .writes<Component::Transform, Component::Pickup>();
+}
+
+void Simulation::setup_level(u32 level_index)
+{
+    if (level_index >= this->assets.levels.size())
+    {
+        game_won = true;
+        return;
+    }
+
+    auto level = this->assets.levels.at(level_index);
+
+    bonus_timer = static_cast<f32>(level.bonus_time_seconds);
+    game_over = false;
+    level_fade = 0.0f;
+    commands.clear();
+    entity_manager.clear();
+    particles.clear();
+    circle_radius = static_cast<f32>(level.circle_radius);
+
+    // PLAYER
+    {
+        // Keep thrust and multi-shot upgrades
+        f32 thrust = 50.0f;
+        u32 multi_shot = 1;
+        if (level_index > 0 && player.has_component<Component::Physics>())
+        {
+            thrust = player.get_component<Component::Physics>().thrust;
+        }
+        if (level_index > 0 && player.has_component<Component::Player>())
+        {
+            multi_shot = player.get_component<Component::Player>().multi_shot_amount;
+        }
+
+        // Respawn player
+        Vector2 pos = Util::get_polar_coordinates(PI2 * 0.75f, circle_radius - 64);
+        f32 angle = Util::get_angle_between_points(pos, { 0.0f, 0.0f });
+        this->player = entity_manager.create_player(this->assets.ships, pos.x, pos.y, angle);
+        this->player.get_component<Component::Physics>().thrust = thrust;
+        this->player.get_component<Component::Player>().multi_shot_amount = multi_shot;
+    }
+    // ENEMIES
+    {
+        Util::shuffle_vector(level.enemy_types);
+        const auto angles = Util::get_evenly_spaced_angles(level.enemy_types.size());
+        for (u32 i = 0; i < level.enemy_types.size(); ++i)
+        {
+            auto type = level.enemy_types.at(i);
+            Vector2 pos = Util::get_polar_coordinates(angles.at(i), circle_radius - 100);
+            f32 angle = Util::get_angle_between_points(pos, { 0.0f, 0.0f });
+            entity_manager.create_enemy_ship(this->assets.ships, type, pos.x, pos.y, angle);
+        }
+    }
+}
+
+bool Simulation::level_finished()
+{
+    auto view = entity_manager.registry.view<Component::Enemy>();
+    return view.begin() == view.end() || game_over;
+}
+
+void Simulation::save_snapshot(std::vector<std::byte>& bytes)
+{
+    bytes.clear();
+    SnapshotWriter writer(bytes, assets);
+
+    writer.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    writer(Snapshot::VERSION);
+
+    writer(level_index);
+    writer(circle_radius);
+    writer(bonus_timer);
+    writer(level_fade);
+    writer(death_distance);
+    writer(pause);
+    writer(game_over);
+    writer(game_won);
+    writer(static_cast<entt::entity>(player));
+    writer(Random::engine());
+    writer(system_state.enemy_thrust.has_value());
+    writer(system_state.enemy_thrust.value_or(0.0f));
+    writer(system_state.enemy_thrust_timer);
+    writer(system_state.circle_damage_counter);
+
+    Snapshot::save_registry(entity_manager, writer);
+}
+
+bool Simulation::load_snapshot(const std::vector<std::byte>& bytes)
+{
+    SnapshotReader reader(bytes.data(), bytes.size(), assets, entity_manager.registry);
+
+    char magic[sizeof(SNAPSHOT_MAGIC)] {};
+    u32 version = 0;
+    reader.read(magic, sizeof(magic));
+    reader(version);
+    if (reader.failed() || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0 || version != Snapshot::VERSION)
+    {
+        return false;
+    }
+
+    // The level state only changes once the whole snapshot turned out fine
+    u32 saved_level_index = 0;
+    f32 saved_circle_radius = 0.0f;
+    f32 saved_bonus_timer = 0.0f;
+    f32 saved_level_fade = 0.0f;
+    f32 saved_death_distance = 0.0f;
+    bool saved_pause = false;
+    bool saved_game_over = false;
+    bool saved_game_won = false;
+    entt::entity saved_player = entt::null;
+    Random::Pcg32 saved_random {};
+    bool saved_has_thrust = false;
+    f32 saved_thrust = 0.0f;
+    SystemState saved_state {};
+    reader(saved_level_index);
+    reader(saved_circle_radius);
+    reader(saved_bonus_timer);
+    reader(saved_level_fade);
+    reader(saved_death_distance);
+    reader(saved_pause);
+    reader(saved_game_over);
+    reader(saved_game_won);
+    reader(saved_player);
+    reader(saved_random);
+    reader(saved_has_thrust);
+    reader(saved_thrust);
+    reader(saved_state.enemy_thrust_timer);
+    reader(saved_state.circle_damage_counter);
+    if (saved_has_thrust) saved_state.enemy_thrust = saved_thrust;
+
+    // Read aside, a snapshot that turns out broken leaves the world running
+    Snapshot::LoadedRegistry loaded;
+    if (reader.failed() || !Snapshot::read_registry(reader, loaded) || reader.get_remaining() != 0
+        || !loaded.registry.valid(saved_player))
+    {
+        return false;
+    }
+
+    commands.clear();
+    particles.clear();
+    Snapshot::apply_registry(entity_manager, loaded);
+    level_index = saved_level_index;
+    circle_radius = saved_circle_radius;
+    bonus_timer = saved_bonus_timer;
+    level_fade = saved_level_fade;
+    death_distance = saved_death_distance;
+    pause = saved_pause;
+    game_over = saved_game_over;
+    game_won = saved_game_won;
+    player = Entity(saved_player, &entity_manager.registry);
+    Random::engine() = saved_random;
+    system_state = saved_state;
+    return true;
+}
+
+void Simulation::update_player(f32 dt, const Input& input)
+{
+    auto& player_component = player.get_component<Component::Player>();
+    auto& player_transform = player.get_component<Component::Transform>();
+    auto& player_physics = player.get_component<Component::Physics>();
+
+    if (input.is_set(InputAction::THRUST)) {
+        player_physics.acc.x += std::cos(player_transform.rotation) * player_physics.thrust * dt;
+        player_physics.acc.y += std::sin(player_transform.rotation) * player_physics.thrust * dt;
+        const f32 magnitude = player_physics.acc.x * player_physics.acc.x + player_physics.acc.y * player_physics.acc.y;
+
+        // Generate sparks when accelerating fast
+        if (magnitude > 800 && Util::random_f32(0.0f, 1.0f) <= 0.01f)
+        {
+            f32 spread = Util::lerp(2.0f, 8.0f, magnitude / 2500.0f);
+            particles.emit(
+                    EffectType::SPARKS,
+                    player_transform.pos.x + Util::random_f32(-spread, spread),
+                    player_transform.pos.y + Util::random_f32(-spread, spread),
+                    Util::random_f32(1.5f, 4.0f));
+        }
+    }
+
+    if (input.is_set(InputAction::SELECT_SHELL))
+    {
+        player_component.projectile_type = ProjectileType::SHELL;
+    }
+
+    if (input.is_set(InputAction::SELECT_LASER))
+    {
+        player_component.projectile_type = ProjectileType::LASER;
+    }
+
+    if (input.is_set(InputAction::SELECT_ROCKET))
+    {
+        player_component.projectile_type = ProjectileType::ROCKET;
+    }
+
+    if (input.is_set(InputAction::SELECT_HOMING))
+    {
+        player_component.projectile_type = ProjectileType::HOMING;
+    }
+
+
+    if (input.is_set(InputAction::ROTATE_RIGHT)) {
+        player_transform.rotation += 3.0f * dt;
+    }
+
+    if (input.is_set(InputAction::ROTATE_LEFT)) {
+        player_transform.rotation -= 3.0f * dt;
+    }
+
+    if (player_component.shoot_delay > 0) player_component.shoot_delay -= 3.0f * dt;
+
+    if (input.is_set(InputAction::SHOOT) && player_component.shoot_delay <= 0) {
+        for (u32 i = 0; i < player_component.multi_shot_amount; ++i)
+        {
+
+            if (player_component.projectile_type == ProjectileType::LASER ||
+               (player_component.projectile_type == ProjectileType::SHELL && player_component.shell_amount > 0) ||
+               (player_component.projectile_type == ProjectileType::ROCKET && player_component.rocket_amount > 0) ||
+               (player_component.projectile_type == ProjectileType::HOMING && player_component.homing_amount > 0))
+            {
+                sound_manager.play_shoot();
+                commands.create_projectile(assets.projectiles, player_component.projectile_type, player, player_transform.pos.x, player_transform.pos.y, player_transform.rotation);
+                player_component.shoot_delay = 1.0f;
+
+                if (player_component.projectile_type == ProjectileType::SHELL)  player_component.shell_amount -= 1;
+                if (player_component.projectile_type == ProjectileType::ROCKET) player_component.rocket_amount -= 1;
+                if (player_component.projectile_type == ProjectileType::HOMING) player_component.homing_amount -= 1;
+
+            } else {
+                sound_manager.play_no_ammo();
+            }
+        }
+    }
+
+    if (player_transform.rotation < 0) {
+        player_transform.rotation += 2 * PI;
+    } else if (player_transform.rotation >= 2 * PI) {
+        player_transform.rotation -= 2 * PI;
+    }
+}
+
+void Simulation::store_previous_transforms()
+{
+    auto view = entity_manager.registry.view<Component::Transform, Component::PreviousTransform>(entt::exclude<Component::Inactive>);
+    for (auto entity : view)
+    {
+        auto [transform, previous] = view.get<Component::Transform, Component::PreviousTransform>(entity);
+        previous.rotation = transform.rotation;
+        previous.pos = transform.pos;
+    }
+}
+
+void Simulation::update(f32 dt, const Input& input)
+{
+    // Nothing runs on the job system between ticks
+    jobs.reset_scratch();
+
+    {
+        ProfileScope scope(profiler, "store_previous_transforms");
+        store_previous_transforms();
+    }
+
+    if (input.is_set(InputAction::SKIP_LEVEL))
+    {
+        setup_level(++level_index);
+    }
+
+    // Check if level finished
+    if (level_finished())
+    {
+        if (level_fade == 0.0f && bonus_timer > 0.0f)
+        {
+            auto& player_component = player.get_component<Component::Player>();
+            player_component.score += this->assets.levels[level_index].bonus_score;
+        }
+
+        level_fade += 2.0f * dt;
+        level_fade = std::min(level_fade, 1.0f);
+
+        if (level_fade >= 0.95f && input.is_set(InputAction::CONFIRM))
+        {
+            if (game_over)
+            {
+                level_index = 0;
+                setup_level(level_index);
+            } else {
+                setup_level(++level_index);
+            }
+        }
+        return;
+    }
+
+    // Pause
+
+    if (input.is_set(InputAction::PAUSE)) {
+        pause = !pause;
+    }
+    if (pause) return;
+
+    // Sounds fade with the distance to the player as of the start of the tick
+    sound_manager.set_listener(player.get_component<Component::Transform>().pos);
+
+    // Update game entities
+
+    SystemContext context {
+        player,
+        entity_manager,
+        sound_manager,
+        broadphase,
+        enemy_index,
+        particles,
+        integrator,
+        jobs,
+        commands,
+        assets,
+        circle_radius,
+        death_distance,
+        game_over,
+        system_state
+    };
+
+    // Make circle smaller
+    circle_radius -= 3.0f * dt;
+    circle_radius = std::max(circle_radius, 100.0f);
+
+    // Increase bonus timer
+    bonus_timer -= 1.0f * dt;
+    bonus_timer = std::max(bonus_timer, 0.0f);
+
+    {
+        ProfileScope scope(profiler, "update_player");
+        update_player(dt, input);
+    }
+    {
+        ProfileScope scope(profiler, FLUSH_COMMANDS);
+        commands.flush(entity_manager);
+    }
+
+    scheduler.run(context, dt, profiler);
+}
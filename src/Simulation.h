@@ -0,0 +1,82 @@
+#pragma once
+
+#include <types.h>
+#include <Entity.h>
+#include <EntityManager.h>
+#include <Assets.h>
+#include <Input.h>
+#include <SpatialHash.h>
+#include <ParticleSystem.h>
+#include <CommandBuffer.h>
+#include <JobSystem.h>
+#include <SystemScheduler.h>
+#include <PhysicsIntegrator.h>
+#include <Profiler.h>
+#include <SoundManager.h>
+
+#include <cstddef>
+#include <vector>
+
+// Everything that makes up a running game, without any window, input
+// device or renderer. Game drives it from the keyboard, the headless
+// AstralindaSim target drives it from scripted input.
+class Simulation
+{
+public:
+    // 0 workers picks one less than the hardware threads
+    Simulation(Assets& assets, SoundManager& sound_manager, u32 worker_count = 0);
+
+    void setup_level(u32 level_index);
+    void update(f32 dt, const Input& input);
+
+    [[nodiscard]] bool level_finished();
+
+    // The whole world between two ticks, the registry, the level and system
+    // state and the random generator, so a loaded snapshot carries on exactly
+    // like the saved simulation would have. Effects aren't part of it.
+    void save_snapshot(std::vector<std::byte>& bytes);
+    // Leaves the world empty if the snapshot is invalid, set up a level then
+    bool load_snapshot(const std::vector<std::byte>& bytes);
+
+    EntityManager entity_manager {};
+    SpatialHash broadphase {};
+    SpatialHash enemy_index {};
+    ParticleSystem particles;
+    PhysicsIntegrator integrator {};
+    CommandBuffer commands {};
+
+    JobSystem jobs;
+    SystemScheduler scheduler;
+
+    // Times every system call, frames are delimited by whoever drives the simulation
+    Profiler profiler {};
+    Entity player;
+
+    bool pause { false };
+    bool game_over { false };
+    bool game_won { false };
+
+    // Projectiles further away from the player than this are removed
+    f32 death_distance { 1024.0f * 2.0f * 1.41421354f };
+
+    // Level stuff
+
+    f32 bonus_timer { 0.0f };
+
+    u32 level_index { 0 };
+    f32 circle_radius { 2000 };
+    f32 level_fade { 0 };
+
+    SystemState system_state {};
+
+    // Done before every tick, and whenever the world jumps so rendering
+    // doesn't interpolate across it
+    void store_previous_transforms();
+
+private:
+    void setup_systems();
+    void update_player(f32 dt, const Input& input);
+
+    Assets& assets;
+    SoundManager& sound_manager;
+};
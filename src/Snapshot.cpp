@@ -0,0 +1,299 @@
+#include <Snapshot.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    constexpr std::uintptr_t NO_TEXTURE = ~std::uintptr_t { 0 };
+
+    // Every texture a sprite can point to, the position is what gets stored
+    template<typename AssetsType>
+    auto get_textures(AssetsType& assets)
+    {
+        return std::array {
+            &assets.title,
+            &assets.ships,
+            &assets.projectiles,
+            &assets.engine,
+            &assets.stars,
+            &assets.effects,
+            &assets.warning,
+            &assets.pickups,
+        };
+    }
+
+    template<typename Type>
+    void save_storage(entt::registry& registry, SnapshotWriter& writer)
+    {
+        const auto& storage = registry.storage<Type>();
+        const auto size = static_cast<u32>(storage.size());
+        writer(size);
+        writer.write(storage.data(), size * sizeof(entt::entity));
+
+        // Components sit in pages, each a run in the same order as the entities
+        if constexpr (entt::component_traits<Type>::page_size != 0u)
+        {
+            constexpr u32 page_size = entt::component_traits<Type>::page_size;
+            for (u32 first = 0; first < size; first += page_size)
+            {
+                writer.write_array(storage.raw()[first / page_size], std::min(page_size, size - first));
+            }
+        }
+    }
+
+    // Every entity has to be in the registry already and the storage empty,
+    // components are read straight into its pages. live holds the entities
+    // in use at their index, a lookup there is cheaper than asking the registry.
+    template<typename Type>
+    bool load_storage(entt::registry& registry, SnapshotReader& reader, std::vector<entt::entity>& entities, std::vector<entt::entity>& live)
+    {
+        u32 size = 0;
+        reader(size);
+        if (reader.failed() || size > reader.get_remaining() / sizeof(entt::entity)) return false;
+
+        entities.resize(size);
+        reader.read(entities.data(), size * sizeof(entt::entity));
+
+        // Crossed off while checking, so an entity listed twice fails too
+        for (const auto entity : entities)
+        {
+            const auto index = entt::to_entity(entity);
+            if (index >= live.size() || live[index] != entity) return false;
+            live[index] = entt::null;
+        }
+        for (const auto entity : entities) live[entt::to_entity(entity)] = entity;
+
+        auto& storage = registry.storage<Type>();
+        storage.reserve(size);
+        storage.insert(entities.begin(), entities.end());
+
+        if constexpr (entt::component_traits<Type>::page_size != 0u)
+        {
+            constexpr u32 page_size = entt::component_traits<Type>::page_size;
+            for (u32 first = 0; first < size; first += page_size)
+            {
+                reader.read_array(storage.raw()[first / page_size], std::min(page_size, size - first));
+            }
+        }
+        return !reader.failed();
+    }
+
+    // Loaded without groups, which are created afterwards. Saved storages
+    // have the owning group's entities in front in group order, so creating
+    // it leaves them where they are.
+    template<typename... Type>
+    struct Storages
+    {
+        static void save(entt::registry& registry, SnapshotWriter& writer)
+        {
+            (save_storage<Type>(registry, writer), ...);
+        }
+
+        static bool load(entt::registry& registry, SnapshotReader& reader, std::vector<entt::entity>& entities, std::vector<entt::entity>& live)
+        {
+            return (load_storage<Type>(registry, reader, entities, live) && ...);
+        }
+    };
+
+    using ComponentStorages = Storages<
+            Component::Inactive,
+            Component::Transform,
+            Component::PreviousTransform,
+            Component::Physics,
+            Component::Sprite,
+            Component::CircleCollider,
+            Component::Health,
+            Component::Player,
+            Component::Enemy,
+            Component::Projectile,
+            Component::Pickup>;
+}
+
+SnapshotWriter::SnapshotWriter(std::vector<std::byte>& bytes, const Assets& assets)
+    : bytes(bytes)
+    , assets(assets)
+{
+}
+
+void SnapshotWriter::write_array(const Component::Sprite* sprites, size_t count)
+{
+    const size_t first = bytes.size();
+    write(sprites, count * sizeof(Component::Sprite));
+
+    const auto textures = get_textures(assets);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto texture = std::find(textures.begin(), textures.end(), sprites[i].texture);
+        const std::uintptr_t index = texture != textures.end() ? static_cast<std::uintptr_t>(texture - textures.begin()) : NO_TEXTURE;
+        std::memcpy(&bytes[first + i * sizeof(Component::Sprite) + offsetof(Component::Sprite, texture)], &index, sizeof(index));
+    }
+}
+
+void SnapshotWriter::write_array(const Component::Projectile* projectiles, size_t count)
+{
+    const size_t first = bytes.size();
+    write(projectiles, count * sizeof(Component::Projectile));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Entity owner(projectiles[i].owner, nullptr);
+        std::memcpy(&bytes[first + i * sizeof(Component::Projectile) + offsetof(Component::Projectile, owner)], &owner, sizeof(owner));
+    }
+}
+
+SnapshotReader::SnapshotReader(const std::byte* data, size_t size, Assets& assets, entt::registry& registry)
+    : data(data)
+    , size(size)
+    , assets(assets)
+    , registry(registry)
+{
+}
+
+void SnapshotReader::read_array(Component::Sprite* sprites, size_t count)
+{
+    read(sprites, count * sizeof(Component::Sprite));
+
+    const auto textures = get_textures(assets);
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::uintptr_t index = NO_TEXTURE;
+        std::memcpy(&index, &sprites[i].texture, sizeof(index));
+        sprites[i].texture = index < textures.size() ? textures[index] : nullptr;
+    }
+}
+
+void SnapshotReader::read_array(Component::Projectile* projectiles, size_t count)
+{
+    read(projectiles, count * sizeof(Component::Projectile));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        projectiles[i].owner = Entity(projectiles[i].owner, &registry);
+    }
+}
+
+void Snapshot::save_registry(EntityManager& entity_manager, SnapshotWriter& writer)
+{
+    auto& registry = entity_manager.registry;
+
+    // Identifiers waiting to be recycled come after the ones in use
+    const auto& entities = registry.storage<entt::entity>();
+    writer(static_cast<u32>(entities.size()));
+    writer(static_cast<u32>(entities.in_use()));
+    writer.write(entities.data(), entities.size() * sizeof(entt::entity));
+
+    ComponentStorages::save(registry, writer);
+
+    // The order of the non-owning group only follows from its history
+    auto projectiles = entity_manager.projectile_group();
+    writer(static_cast<u32>(projectiles.size()));
+    for (const auto entity : projectiles) writer(entity);
+}
+
+bool Snapshot::read_registry(SnapshotReader& reader, LoadedRegistry& loaded)
+{
+    auto& registry = loaded.registry;
+
+    u32 size = 0;
+    u32 in_use = 0;
+    reader(size);
+    reader(in_use);
+    bool valid = !reader.failed() && in_use <= size && size <= reader.get_remaining() / sizeof(entt::entity);
+
+    std::vector<entt::entity> entities;
+    std::vector<entt::entity> live;
+    if (valid)
+    {
+        entities.resize(size);
+        reader.read(entities.data(), size * sizeof(entt::entity));
+
+        auto& storage = registry.storage<entt::entity>();
+        storage.reserve(size);
+        for (u32 i = 0; valid && i < size; ++i)
+        {
+            valid = storage.emplace(entities[i]) == entities[i];
+        }
+        storage.in_use(in_use);
+
+        // Every index below the storage's size is taken, the ones in use come first
+        live.assign(storage.size(), entt::null);
+        for (u32 i = 0; valid && i < in_use; ++i)
+        {
+            live[entt::to_entity(entities[i])] = entities[i];
+        }
+    }
+
+    valid = valid && ComponentStorages::load(registry, reader, entities, live);
+
+    u32 count = 0;
+    reader(count);
+    valid = valid && !reader.failed() && count <= reader.get_remaining() / sizeof(entt::entity);
+    if (!valid) return false;
+
+    entities.resize(count);
+    reader.read(entities.data(), count * sizeof(entt::entity));
+    loaded.projectile_positions.assign(registry.storage<entt::entity>().size(), 0);
+    for (u32 i = 0; i < count; ++i)
+    {
+        const auto index = entt::to_entity(entities[i]);
+        if (index < loaded.projectile_positions.size()) loaded.projectile_positions[index] = i;
+    }
+    return true;
+}
+
+void Snapshot::apply_registry(EntityManager& entity_manager, LoadedRegistry& loaded)
+{
+    // Filled storages are cheaper to group than filling grouped storages
+    entity_manager.replace_registry(std::move(loaded.registry));
+
+    const auto& positions = loaded.projectile_positions;
+    entity_manager.projectile_group().sort([&](entt::entity a, entt::entity b) {
+        return positions[entt::to_entity(a)] < positions[entt::to_entity(b)];
+    });
+}
+
+bool Snapshot::load_registry(EntityManager& entity_manager, SnapshotReader& reader)
+{
+    LoadedRegistry loaded;
+    if (!read_registry(reader, loaded)) return false;
+
+    apply_registry(entity_manager, loaded);
+    return true;
+}
+
+bool Snapshot::write_file(const std::string& file, const std::vector<std::byte>& bytes)
+{
+    // Written next to it first, a crash or a full disk halfway leaves the
+    // old file whole. Unlike std::rename this replaces it on Windows too.
+    const std::string temporary = file + ".tmp";
+    std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) return false;
+    output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    output.close();
+
+    std::error_code error;
+    if (!output)
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    std::filesystem::rename(temporary, file, error);
+    return !error;
+}
+
+std::optional<std::vector<std::byte>> Snapshot::read_file(const std::string& file)
+{
+    std::ifstream input(file, std::ios::binary | std::ios::ate);
+    if (!input.is_open()) return std::nullopt;
+
+    std::vector<std::byte> bytes(static_cast<size_t>(input.tellg()));
+    input.seekg(0);
+    if (!input.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) return std::nullopt;
+    return bytes;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <types.h>
+#include <Assets.h>
+#include <Component.h>
+#include <EntityManager.h>
+
+#include <entt/entt.hpp>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Snapshot
+{
+    // Components holding pointers. They're copied like the rest and the
+    // pointers replaced in the copy, sprite textures by their index in
+    // Assets and projectile owners by their bare entity.
+    template<typename T>
+    constexpr bool is_remapped = std::is_same_v<T, Component::Sprite> || std::is_same_v<T, Component::Projectile>;
+}
+
+// Binary archives for registry snapshots. Values are copied as raw bytes,
+// components one storage at a time. Entities keep their identifiers, so
+// handles stored in components stay valid.
+class SnapshotWriter
+{
+public:
+    SnapshotWriter(std::vector<std::byte>& bytes, const Assets& assets);
+
+    template<typename T>
+    void operator()(const T& value)
+    {
+        write_array(&value, 1);
+    }
+
+    template<typename T>
+    void write_array(const T* values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && !Snapshot::is_remapped<T>, "Components with pointers need an overload of their own");
+        write(values, count * sizeof(T));
+    }
+    void write_array(const Component::Sprite* sprites, size_t count);
+    void write_array(const Component::Projectile* projectiles, size_t count);
+
+    void write(const void* data, size_t size)
+    {
+        const auto* first = static_cast<const std::byte*>(data);
+        bytes.insert(bytes.end(), first, first + size);
+    }
+
+private:
+    std::vector<std::byte>& bytes;
+    const Assets& assets;
+};
+
+// Reading past the end zeroes the values and marks the reader as failed
+class SnapshotReader
+{
+public:
+    SnapshotReader(const std::byte* data, size_t size, Assets& assets, entt::registry& registry);
+
+    template<typename T>
+    void operator()(T& value)
+    {
+        read_array(&value, 1);
+    }
+
+    template<typename T>
+    void read_array(T* values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && !Snapshot::is_remapped<T>, "Components with pointers need an overload of their own");
+        read(values, count * sizeof(T));
+    }
+    void read_array(Component::Sprite* sprites, size_t count);
+    void read_array(Component::Projectile* projectiles, size_t count);
+
+    void read(void* value, size_t value_size)
+    {
+        if (overrun || value_size > size - offset)
+        {
+            overrun = true;
+            std::memset(value, 0, value_size);
+            return;
+        }
+        std::memcpy(value, data + offset, value_size);
+        offset += value_size;
+    }
+
+    [[nodiscard]] bool failed() const { return overrun; }
+    [[nodiscard]] size_t get_remaining() const { return size - offset; }
+
+private:
+    const std::byte* data;
+    size_t size;
+    size_t offset { 0 };
+    bool overrun { false };
+    Assets& assets;
+    entt::registry& registry;
+};
+
+namespace Snapshot
+{
+    // Bumped whenever a component or the simulation state changes layout
+    constexpr u32 VERSION = 2;
+
+    // Every entity and component, including the pooled projectiles and the
+    // identifiers waiting to be recycled, so entities created after loading
+    // get the same handles they would have gotten before saving. Storages
+    // are written as blocks in their packed order and inserted in bulk.
+    void save_registry(EntityManager& entity_manager, SnapshotWriter& writer);
+    // A registry read from a snapshot, kept apart from the one in use until
+    // everything else in the snapshot turned out fine too
+    struct LoadedRegistry
+    {
+        entt::registry registry;
+        // Position of each projectile in its group, by entity index
+        std::vector<u32> projectile_positions;
+    };
+
+    // loaded has to be new. The reader's registry is only where projectile
+    // owners will point, nothing in it changes.
+    bool read_registry(SnapshotReader& reader, LoadedRegistry& loaded);
+    // Replaces everything in entity_manager with a registry read before
+    void apply_registry(EntityManager& entity_manager, LoadedRegistry& loaded);
+    // Both at once, entity_manager stays as it was if loading fails
+    bool load_registry(EntityManager& entity_manager, SnapshotReader& reader);
+
+    bool write_file(const std::string& file, const std::vector<std::byte>& bytes);
+    std::optional<std::vector<std::byte>> read_file(const std::string& file);
+}
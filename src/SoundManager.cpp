@@ -2,33 +2,238 @@
 #include <raylib.h>
 #include <Util.h>
 
-SoundManager::SoundManager(Assets& assets)
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    struct SoundConfig
+    {
+        f32 volume;
+        u8 max_voices;
+        // Higher steals from lower
+        u8 priority;
+    };
+
+    // Indexed by SoundId
+    constexpr SoundConfig SOUND_CONFIGS[] = {
+        { 0.25f, 2, 2 }, // HIT_LASER1
+        { 0.25f, 2, 2 }, // HIT_LASER2
+        { 0.25f, 2, 2 }, // HIT1
+        { 0.25f, 2, 2 }, // HIT2
+        { 0.25f, 2, 2 }, // HIT3
+        { 0.25f, 4, 1 }, // SHOOT
+        { 0.25f, 1, 5 }, // GAME_OVER
+        { 0.25f, 3, 3 }, // SHIP_DEATH
+        { 0.25f, 1, 1 }, // NO_AMMO
+        { 0.25f, 2, 4 }, // PICKUP
+    };
+    static_assert(std::size(SOUND_CONFIGS) == static_cast<size_t>(SoundId::COUNT));
+
+    // Voices playing at once over all sounds
+    constexpr u32 MAX_VOICES = 16;
+
+    // Positional sounds are at full volume up to here and fade out linearly
+    // until the edge of the screen's circle and a bit
+    constexpr f32 FULL_VOLUME_DISTANCE = 400.0f;
+    constexpr f32 AUDIBLE_DISTANCE = 1600.0f;
+
+    const SoundConfig& get_config(SoundId sound)
+    {
+        return SOUND_CONFIGS[static_cast<size_t>(sound)];
+    }
+}
+
+SoundManager::SoundManager(Assets& assets, std::unique_ptr<AudioBackend> backend)
     : assets(assets)
+    , backend(std::move(backend))
+{
+}
+
+void SoundManager::set_listener(Vector2 position)
+{
+    listener = position;
+}
+
+const Sound& SoundManager::get_sound(SoundId sound) const
+{
+    switch (sound)
+    {
+        case SoundId::HIT_LASER1: return assets.hit_laser1;
+        case SoundId::HIT_LASER2: return assets.hit_laser2;
+        case SoundId::HIT1:       return assets.hit1;
+        case SoundId::HIT2:       return assets.hit2;
+        case SoundId::HIT3:       return assets.hit3;
+        case SoundId::SHOOT:      return assets.shoot1;
+        case SoundId::GAME_OVER:  return assets.game_over1;
+        case SoundId::SHIP_DEATH: return assets.ship_death;
+        case SoundId::NO_AMMO:    return assets.no_ammo;
+        case SoundId::PICKUP:     return assets.pickup;
+        case SoundId::COUNT:      break;
+    }
+    return assets.hit1;
+}
+
+void SoundManager::play(SoundId sound)
+{
+    stats.requested += 1;
+    request(sound, 1.0f);
+}
+
+void SoundManager::play(SoundId sound, Vector2 position)
+{
+    stats.requested += 1;
+
+    const f32 distance = Util::distance_between_points(listener, position);
+    if (distance > AUDIBLE_DISTANCE)
+    {
+        stats.culled += 1;
+        return;
+    }
+
+    const f32 fade = (distance - FULL_VOLUME_DISTANCE) / (AUDIBLE_DISTANCE - FULL_VOLUME_DISTANCE);
+    request(sound, 1.0f - std::clamp(fade, 0.0f, 1.0f));
+}
+
+void SoundManager::request(SoundId sound, f32 volume)
 {
+    auto& channel = channels[static_cast<size_t>(sound)];
+    if (channel.pending)
+    {
+        stats.merged += 1;
+        channel.volume = std::max(channel.volume, volume);
+        return;
+    }
+
+    channel.pending = true;
+    channel.volume = volume;
 }
 
+std::optional<u32> SoundManager::find_victim(u8 priority) const
+{
+    std::optional<u32> victim;
+    for (u32 i = 0; i < voices.size(); ++i)
+    {
+        const auto& voice = voices[i];
+        if (get_config(voice.sound).priority >= priority || !backend->is_playing(voice.handle)) continue;
 
-void SoundManager::play_hit(ProjectileType type)
+        // Lowest priority first, the oldest of those
+        if (!victim.has_value()
+            || get_config(voice.sound).priority < get_config(voices[*victim].sound).priority
+            || (get_config(voice.sound).priority == get_config(voices[*victim].sound).priority && voice.started < voices[*victim].started))
+        {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+void SoundManager::flush()
+{
+    flush_index += 1;
+
+    // Higher priorities pick their voices first
+    std::array<u8, static_cast<size_t>(SoundId::COUNT)> order {};
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [](u8 a, u8 b) {
+        return SOUND_CONFIGS[a].priority > SOUND_CONFIGS[b].priority;
+    });
+
+    u32 playing = 0;
+    for (const auto& voice : voices)
+    {
+        if (backend->is_playing(voice.handle)) playing += 1;
+    }
+
+    for (const u8 index : order)
+    {
+        const auto sound = static_cast<SoundId>(index);
+        const auto& config = get_config(sound);
+        auto& channel = channels[index];
+        if (!channel.pending) continue;
+        channel.pending = false;
+
+        // The sound may still be loading, its voices are made on first use
+        while (channel.voices.size() < config.max_voices)
+        {
+            const auto handle = backend->create_voice(get_sound(sound));
+            if (!handle.has_value()) break;
+            voices.push_back({ handle.value(), sound, 0 });
+            channel.voices.push_back(static_cast<u32>(voices.size() - 1));
+        }
+        if (channel.voices.empty())
+        {
+            stats.dropped += 1;
+            continue;
+        }
+
+        // A free voice of its own, otherwise its oldest one starts over
+        std::optional<u32> chosen;
+        u32 oldest = channel.voices[0];
+        for (const u32 voice : channel.voices)
+        {
+            if (!backend->is_playing(voices[voice].handle))
+            {
+                chosen = voice;
+                break;
+            }
+            if (voices[voice].started < voices[oldest].started) oldest = voice;
+        }
+
+        if (!chosen.has_value())
+        {
+            chosen = oldest;
+            stats.stolen += 1;
+        }
+        else if (playing >= MAX_VOICES)
+        {
+            const auto victim = find_victim(config.priority);
+            if (!victim.has_value())
+            {
+                stats.dropped += 1;
+                continue;
+            }
+            backend->stop(voices[victim.value()].handle);
+            stats.stolen += 1;
+        }
+        else
+        {
+            playing += 1;
+        }
+
+        auto& voice = voices[chosen.value()];
+        voice.started = flush_index;
+        backend->play(voice.handle, config.volume * channel.volume);
+        stats.played += 1;
+    }
+}
+
+void SoundManager::play_hit(ProjectileType type, Vector2 position)
 {
     if (type == ProjectileType::LASER)
     {
-        PlaySound(Util::random_u32(1, 2) == 2 ? assets.hit_laser1 : assets.hit_laser2);
+        play(Util::random_u32(1, 2) == 2 ? SoundId::HIT_LASER1 : SoundId::HIT_LASER2, position);
     } else {
         u32 sound = Util::random_u32(1, 3);
-        if      (sound == 1) PlaySound(assets.hit1);
-        else if (sound == 2) PlaySound(assets.hit2);
-        else if (sound == 3) PlaySound(assets.hit3);
+        if      (sound == 1) play(SoundId::HIT1, position);
+        else if (sound == 2) play(SoundId::HIT2, position);
+        else if (sound == 3) play(SoundId::HIT3, position);
     }
 }
 
 void SoundManager::play_shoot()
 {
-    PlaySound(assets.shoot1);
+    play(SoundId::SHOOT);
 }
 
-void SoundManager::play_die()
+void SoundManager::play_shoot(Vector2 position)
 {
-    PlaySound(assets.ship_death);
+    play(SoundId::SHOOT, position);
+}
+
+void SoundManager::play_die(Vector2 position)
+{
+    play(SoundId::SHIP_DEATH, position);
 }
 
 void SoundManager::play_engine()
@@ -43,7 +248,7 @@ void SoundManager::play_warning()
 
 void SoundManager::play_pickup()
 {
-    PlaySound(assets.pickup);
+    play(SoundId::PICKUP);
 }
 
 void SoundManager::play_win_level()
@@ -53,11 +258,10 @@ void SoundManager::play_win_level()
 
 void SoundManager::play_game_over()
 {
-    PlaySound(assets.game_over1);
+    play(SoundId::GAME_OVER);
 }
 
 void SoundManager::play_no_ammo()
 {
-    PlaySound(assets.no_ammo);
+    play(SoundId::NO_AMMO);
 }
-
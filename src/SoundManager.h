@@ -1,16 +1,61 @@
-
 #pragma once
 
 #include <Assets.h>
+#include <AudioBackend.h>
+
+#include <array>
+#include <optional>
+#include <vector>
+#include <memory>
+
+enum class SoundId : u8
+{
+    HIT_LASER1 = 0,
+    HIT_LASER2,
+    HIT1,
+    HIT2,
+    HIT3,
+    SHOOT,
+    GAME_OVER,
+    SHIP_DEATH,
+    NO_AMMO,
+    PICKUP,
+    COUNT
+};
 
+// Mixer in front of the audio backend. Requests are queued and flush()
+// plays them once per frame: requests for the same sound in one frame are
+// merged into a single play at the loudest volume, every sound has a cap on
+// its voices and all of them together share a global cap, where higher
+// priority sounds steal voices from lower ones. Sounds with a position
+// fade with distance to the listener and are dropped when out of range.
 class SoundManager
 {
 public:
-    SoundManager(Assets& assets);
+    // Plays nothing without a backend
+    explicit SoundManager(Assets& assets, std::unique_ptr<AudioBackend> backend = std::make_unique<NullAudioBackend>());
 
-    void play_hit(ProjectileType type);
+    struct Stats
+    {
+        u64 requested { 0 };
+        // Out of range, never queued
+        u64 culled { 0 };
+        // Folded into another request for the same sound
+        u64 merged { 0 };
+        u64 played { 0 };
+        // Voices cut short for a higher priority sound
+        u64 stolen { 0 };
+        // No voice left that could be taken
+        u64 dropped { 0 };
+    };
+
+    void set_listener(Vector2 position);
+
+    void play_hit(ProjectileType type, Vector2 position);
+    // Without a position the sound is the listener's own
     void play_shoot();
-    void play_die();
+    void play_shoot(Vector2 position);
+    void play_die(Vector2 position);
     void play_engine();
     void play_warning();
     void play_pickup();
@@ -18,6 +63,43 @@ public:
     void play_game_over();
     void play_no_ammo();
 
+    // Plays what was requested since the last flush
+    void flush();
+
+    [[nodiscard]] const Stats& get_stats() const { return stats; }
+    [[nodiscard]] AudioBackend& get_backend() { return *backend; }
+
 private:
+    struct Voice
+    {
+        u32 handle;
+        SoundId sound;
+        // Flush it was started in, the oldest one goes first when stealing
+        u64 started;
+    };
+
+    struct Channel
+    {
+        // Indices into voices, created once the sound is loaded
+        std::vector<u32> voices {};
+        bool pending { false };
+        f32 volume { 0.0f };
+    };
+
+    void play(SoundId sound);
+    void play(SoundId sound, Vector2 position);
+    void request(SoundId sound, f32 volume);
+    [[nodiscard]] const Sound& get_sound(SoundId sound) const;
+    // Oldest playing voice of any sound with a lower priority
+    [[nodiscard]] std::optional<u32> find_victim(u8 priority) const;
+
     Assets& assets;
-};
\ No newline at end of file
+    std::unique_ptr<AudioBackend> backend;
+
+    std::array<Channel, static_cast<size_t>(SoundId::COUNT)> channels {};
+    std::vector<Voice> voices {};
+    u64 flush_index { 0 };
+
+    Vector2 listener { 0.0f, 0.0f };
+    Stats stats {};
+};
@@ -0,0 +1,88 @@
+#include <SpatialHash.h>
+
+#include <algorithm>
+
+SpatialHash::SpatialHash(f32 cell_size, u32 bucket_count)
+    : inverse_cell_size(1.0f / cell_size)
+    , min_bucket_count(bucket_count)
+    , bucket_count(0)
+{
+}
+
+void SpatialHash::clear()
+{
+    entries.clear();
+    entry_buckets.clear();
+    sorted_entries.clear();
+    max_radius = 0.0f;
+}
+
+void SpatialHash::insert(entt::entity entity, Vector2 pos, f32 radius)
+{
+    entries.push_back({ entity, pos, radius });
+    max_radius = std::max(max_radius, radius);
+}
+
+void SpatialHash::build()
+{
+    // At least two buckets per entry so they stay short however far the
+    // entries spread, rounded up to a power of two so buckets can be
+    // picked with a mask
+    u32 wanted = std::max(min_bucket_count, static_cast<u32>(entries.size()) * 2);
+    u32 count = 1;
+    while (count < wanted) count <<= 1;
+    if (count != bucket_count)
+    {
+        bucket_count = count;
+        bucket_start.resize(bucket_count + 1);
+    }
+
+    // Bucket indices depend on the bounds
+    if (!entries.empty())
+    {
+        min_cell_x = max_cell_x = cell_coordinate(entries[0].pos.x);
+        min_cell_y = max_cell_y = cell_coordinate(entries[0].pos.y);
+        for (const auto& entry : entries)
+        {
+            const s32 cx = cell_coordinate(entry.pos.x);
+            const s32 cy = cell_coordinate(entry.pos.y);
+            min_cell_x = std::min(min_cell_x, cx);
+            max_cell_x = std::max(max_cell_x, cx);
+            min_cell_y = std::min(min_cell_y, cy);
+            max_cell_y = std::max(max_cell_y, cy);
+        }
+        // Odd, so rows that wrap around don't land on the same buckets as a whole
+        row_length = (static_cast<u32>(max_cell_x - min_cell_x) + 1) | 1u;
+    }
+
+    entry_buckets.resize(entries.size());
+    for (u32 i = 0; i < entries.size(); ++i)
+    {
+        entry_buckets[i] = bucket_index(cell_coordinate(entries[i].pos.x), cell_coordinate(entries[i].pos.y));
+    }
+
+    // Counting sort the entries by bucket, bucket_start[b]..bucket_start[b + 1]
+    // is then the range of entries that landed in bucket b.
+    std::fill(bucket_start.begin(), bucket_start.end(), 0);
+    for (auto bucket : entry_buckets)
+    {
+        bucket_start[bucket + 1] += 1;
+    }
+    for (u32 i = 0; i < bucket_count; ++i)
+    {
+        bucket_start[i + 1] += bucket_start[i];
+    }
+
+    sorted_entries.resize(entries.size());
+    for (u32 i = 0; i < entries.size(); ++i)
+    {
+        sorted_entries[bucket_start[entry_buckets[i]]++] = entries[i];
+    }
+
+    // The increments above shifted every start to the next bucket's start
+    for (u32 i = bucket_count; i > 0; --i)
+    {
+        bucket_start[i] = bucket_start[i - 1];
+    }
+    bucket_start[0] = 0;
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <types.h>
+
+#include <entt/entt.hpp>
+#include <raylib.h>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+// Uniform grid broadphase. Entities are bucketed by the cell their center
+// falls in, and queries widen their search by the largest inserted radius,
+// so every entity only has to be stored once.
+class SpatialHash
+{
+public:
+    struct Entry
+    {
+        entt::entity entity { entt::null };
+        Vector2 pos { 0.0f, 0.0f };
+        f32 radius { 0.0f };
+    };
+
+    // bucket_count is the least there will be, build() adds more for
+    // larger entry counts
+    explicit SpatialHash(f32 cell_size = 128.0f, u32 bucket_count = 4096);
+
+    void clear();
+    void insert(entt::entity entity, Vector2 pos, f32 radius);
+
+    // Sorts the inserted entries into their buckets, must be called after
+    // the last insert and before any query.
+    void build();
+
+    // Calls func(const Entry&) for every entry whose cell is close enough
+    // to possibly overlap the given circle. Entries that share a bucket
+    // through a hash collision are included too, so callers still have to
+    // run the narrowphase.
+    template<typename Func>
+    void query(Vector2 pos, f32 radius, Func&& func) const
+    {
+        query_cells(pos, radius + max_radius, std::forward<Func>(func));
+    }
+
+    // Calls func(const Entry&) for every entry whose center is within radius of pos
+    template<typename Func>
+    void query_within(Vector2 pos, f32 radius, Func&& func) const
+    {
+        const f32 radius_squared = radius * radius;
+        query_cells(pos, radius, [&](const Entry& entry)
+        {
+            if (distance_squared(pos, entry.pos) <= radius_squared) func(entry);
+        });
+    }
+
+    // Closest entry to pos, within max_distance, that filter(const Entry&)
+    // accepts. Searches rings of cells outwards and stops as soon as no
+    // unvisited cell can hold anything closer.
+    template<typename Filter>
+    [[nodiscard]] const Entry* nearest(Vector2 pos, f32 max_distance, Filter&& filter) const
+    {
+        const Entry* best = nullptr;
+        f32 best_distance_squared = max_distance * max_distance;
+
+        visit_rings(pos, max_distance, [&](const Entry& entry)
+        {
+            const f32 d = distance_squared(pos, entry.pos);
+            if (d < best_distance_squared && filter(entry))
+            {
+                best = &entry;
+                best_distance_squared = d;
+            }
+            return best_distance_squared;
+        });
+        return best;
+    }
+
+    [[nodiscard]] const Entry* nearest(Vector2 pos, f32 max_distance) const
+    {
+        return nearest(pos, max_distance, [](const Entry&) { return true; });
+    }
+
+    // Up to k closest accepted entries within max_distance, closest first.
+    // Returns how many were found.
+    template<typename Filter>
+    u32 k_nearest(Vector2 pos, u32 k, f32 max_distance, std::vector<Entry>& result, Filter&& filter) const
+    {
+        result.clear();
+        if (k == 0) return 0;
+
+        std::vector<f32> distances;
+        const f32 max_distance_squared = max_distance * max_distance;
+
+        visit_rings(pos, max_distance, [&](const Entry& entry)
+        {
+            const f32 d = distance_squared(pos, entry.pos);
+            const bool full = result.size() == k;
+            if (d <= max_distance_squared && (!full || d < distances.back()) && filter(entry))
+            {
+                // Hash collisions can bring the same bucket up twice
+                const bool seen = std::any_of(result.begin(), result.end(), [&](const Entry& other) {
+                    return other.entity == entry.entity;
+                });
+                if (!seen)
+                {
+                    if (full)
+                    {
+                        result.pop_back();
+                        distances.pop_back();
+                    }
+                    const auto at = std::upper_bound(distances.begin(), distances.end(), d) - distances.begin();
+                    distances.insert(distances.begin() + at, d);
+                    result.insert(result.begin() + at, entry);
+                }
+            }
+            return result.size() == k ? distances.back() : max_distance_squared;
+        });
+        return static_cast<u32>(result.size());
+    }
+
+    [[nodiscard]] u32 size() const { return static_cast<u32>(entries.size()); }
+
+private:
+    static f32 distance_squared(Vector2 a, Vector2 b)
+    {
+        const f32 dx = a.x - b.x;
+        const f32 dy = a.y - b.y;
+        return dx * dx + dy * dy;
+    }
+
+    // Visits the cells of growing square rings around pos. func(const Entry&)
+    // returns the squared distance anything still has to beat, once the
+    // next ring is further away than that the search ends.
+    template<typename Func>
+    void visit_rings(Vector2 pos, f32 max_distance, Func&& func) const
+    {
+        if (sorted_entries.empty()) return;
+
+        const s32 px = cell_coordinate(pos.x);
+        const s32 py = cell_coordinate(pos.y);
+
+        // Past this ring every occupied cell has been visited
+        const s32 last_ring = std::max(std::max(std::abs(px - min_cell_x), std::abs(px - max_cell_x)),
+                                       std::max(std::abs(py - min_cell_y), std::abs(py - max_cell_y)));
+
+        f32 limit_squared = max_distance * max_distance;
+        auto visit_cell = [&](s32 cx, s32 cy)
+        {
+            const u32 bucket = bucket_index(cx, cy);
+            for (u32 i = bucket_start[bucket]; i < bucket_start[bucket + 1]; ++i)
+            {
+                limit_squared = func(sorted_entries[i]);
+            }
+        };
+
+        for (s32 ring = 0; ring <= last_ring; ++ring)
+        {
+            // Closest any point in this ring can be
+            const f32 ring_distance = static_cast<f32>(std::max(ring - 1, 0)) / inverse_cell_size;
+            if (ring_distance * ring_distance > limit_squared) break;
+
+            if (ring == 0)
+            {
+                visit_cell(px, py);
+                continue;
+            }
+
+            for (s32 cx = px - ring; cx <= px + ring; ++cx)
+            {
+                visit_cell(cx, py - ring);
+                visit_cell(cx, py + ring);
+            }
+            for (s32 cy = py - ring + 1; cy <= py + ring - 1; ++cy)
+            {
+                visit_cell(px - ring, cy);
+                visit_cell(px + ring, cy);
+            }
+        }
+    }
+
+    template<typename Func>
+    void query_cells(Vector2 pos, f32 radius, Func&& func) const
+    {
+        if (sorted_entries.empty()) return;
+
+        const s32 min_x = cell_coordinate(pos.x - radius);
+        const s32 max_x = cell_coordinate(pos.x + radius);
+        const s32 min_y = cell_coordinate(pos.y - radius);
+        const s32 max_y = cell_coordinate(pos.y + radius);
+
+        for (s32 cy = min_y; cy <= max_y; ++cy)
+        {
+            for (s32 cx = min_x; cx <= max_x; ++cx)
+            {
+                const u32 bucket = bucket_index(cx, cy);
+                for (u32 i = bucket_start[bucket]; i < bucket_start[bucket + 1]; ++i)
+                {
+                    func(sorted_entries[i]);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] s32 cell_coordinate(f32 value) const
+    {
+        return static_cast<s32>(std::floor(value * inverse_cell_size));
+    }
+
+    // Cells are numbered row by row over the bounds of what was inserted,
+    // so neighbouring cells share cache lines, and wrapped into the buckets
+    [[nodiscard]] u32 bucket_index(s32 cx, s32 cy) const
+    {
+        const u32 cell = static_cast<u32>(cx - min_cell_x) + static_cast<u32>(cy - min_cell_y) * row_length;
+        return cell & (bucket_count - 1);
+    }
+
+    f32 inverse_cell_size;
+    u32 min_bucket_count;
+    u32 bucket_count;
+    f32 max_radius { 0.0f };
+
+    // Cell bounds of everything inserted, where ring searches can stop
+    s32 min_cell_x { 0 };
+    s32 max_cell_x { 0 };
+    s32 min_cell_y { 0 };
+    s32 max_cell_y { 0 };
+    u32 row_length { 1 };
+
+    std::vector<Entry> entries;
+    std::vector<u32> entry_buckets;
+    std::vector<Entry> sorted_entries;
+    std::vector<u32> bucket_start;
+};
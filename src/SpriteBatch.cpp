@@ -0,0 +1,176 @@
+#include <SpriteBatch.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+    constexpr u32 ATLAS_PADDING = 2;
+
+    u32 next_power_of_two(u32 value)
+    {
+        u32 result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+}
+
+SpriteBatch::SpriteBatch(u32 max_quads)
+{
+    batch = rlLoadRenderBatch(1, static_cast<int>(max_quads));
+}
+
+SpriteBatch::~SpriteBatch()
+{
+    rlUnloadRenderBatch(batch);
+    if (atlas.id > 0) UnloadTexture(atlas);
+}
+
+void SpriteBatch::build_atlas(const std::vector<Sheet>& sheets)
+{
+    // Shelf packing, tallest sheets first, each shelf as high as its first sheet
+    std::vector<u32> order(sheets.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+        return sheets[a].image.height > sheets[b].image.height;
+    });
+
+    u32 widest = 0;
+    for (const auto& sheet : sheets) widest = std::max(widest, static_cast<u32>(sheet.image.width));
+    const u32 atlas_width = next_power_of_two(std::max(widest + ATLAS_PADDING, 256u));
+
+    std::vector<Vector2> offsets(sheets.size());
+    u32 x = 0;
+    u32 y = 0;
+    u32 shelf_height = 0;
+    for (auto i : order)
+    {
+        const auto& image = sheets[i].image;
+        if (x + image.width > atlas_width)
+        {
+            x = 0;
+            y += shelf_height + ATLAS_PADDING;
+            shelf_height = 0;
+        }
+        offsets[i] = { static_cast<f32>(x), static_cast<f32>(y) };
+        x += image.width + ATLAS_PADDING;
+        shelf_height = std::max(shelf_height, static_cast<u32>(image.height));
+    }
+    const u32 atlas_height = next_power_of_two(y + shelf_height);
+
+    // Copy the pixels row by row, everything in RGBA8
+    Image atlas_image = GenImageColor(static_cast<int>(atlas_width), static_cast<int>(atlas_height), BLANK);
+    auto* atlas_pixels = static_cast<u8*>(atlas_image.data);
+
+    regions.clear();
+    for (u32 i = 0; i < sheets.size(); ++i)
+    {
+        // Sheets from the asset archive already are RGBA8 and are read in place
+        Image image = sheets[i].image;
+        const bool converted = image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+        if (converted)
+        {
+            image = ImageCopy(image);
+            ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        }
+
+        const auto* pixels = static_cast<const u8*>(image.data);
+        const u32 offset_x = static_cast<u32>(offsets[i].x);
+        const u32 offset_y = static_cast<u32>(offsets[i].y);
+        for (u32 row = 0; row < static_cast<u32>(image.height); ++row)
+        {
+            std::memcpy(atlas_pixels + ((offset_y + row) * atlas_width + offset_x) * 4,
+                        pixels + row * image.width * 4,
+                        image.width * 4);
+        }
+        if (converted) UnloadImage(image);
+
+        regions.push_back({ sheets[i].texture, offsets[i] });
+    }
+
+    if (atlas.id > 0) UnloadTexture(atlas);
+    atlas = LoadTextureFromImage(atlas_image);
+    UnloadImage(atlas_image);
+
+    inverse_atlas_width = 1.0f / static_cast<f32>(atlas.width);
+    inverse_atlas_height = 1.0f / static_cast<f32>(atlas.height);
+    last_region = nullptr;
+}
+
+Vector2 SpriteBatch::find_offset(const Texture2D* sheet)
+{
+    // Consecutive sprites tend to come from the same sheet
+    if (last_region != nullptr && last_region->texture == sheet) return last_region->offset;
+
+    for (const auto& region : regions)
+    {
+        if (region.texture == sheet)
+        {
+            last_region = &region;
+            return region.offset;
+        }
+    }
+    return { 0.0f, 0.0f };
+}
+
+void SpriteBatch::begin()
+{
+    // Flushes whatever was queued in the default batch so draw order is kept
+    rlSetRenderBatchActive(&batch);
+    rlSetTexture(atlas.id);
+    rlBegin(RL_QUADS);
+}
+
+void SpriteBatch::draw(const Texture2D* sheet, Rectangle source, Rectangle dest, Vector2 origin, f32 rotation, Color tint)
+{
+    const Vector2 offset = find_offset(sheet);
+
+    const f32 u0 = (offset.x + source.x) * inverse_atlas_width;
+    const f32 v0 = (offset.y + source.y) * inverse_atlas_height;
+    const f32 u1 = (offset.x + source.x + source.width) * inverse_atlas_width;
+    const f32 v1 = (offset.y + source.y + source.height) * inverse_atlas_height;
+
+    // Same corner math as DrawTexturePro
+    const f32 sin_rotation = std::sin(rotation * DEG2RAD);
+    const f32 cos_rotation = std::cos(rotation * DEG2RAD);
+    const f32 dx = -origin.x;
+    const f32 dy = -origin.y;
+
+    const Vector2 top_left {
+        dest.x + dx * cos_rotation - dy * sin_rotation,
+        dest.y + dx * sin_rotation + dy * cos_rotation
+    };
+    const Vector2 top_right {
+        dest.x + (dx + dest.width) * cos_rotation - dy * sin_rotation,
+        dest.y + (dx + dest.width) * sin_rotation + dy * cos_rotation
+    };
+    const Vector2 bottom_left {
+        dest.x + dx * cos_rotation - (dy + dest.height) * sin_rotation,
+        dest.y + dx * sin_rotation + (dy + dest.height) * cos_rotation
+    };
+    const Vector2 bottom_right {
+        dest.x + (dx + dest.width) * cos_rotation - (dy + dest.height) * sin_rotation,
+        dest.y + (dx + dest.width) * sin_rotation + (dy + dest.height) * cos_rotation
+    };
+
+    rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+    rlTexCoord2f(u0, v0);
+    rlVertex2f(top_left.x, top_left.y);
+    rlTexCoord2f(u0, v1);
+    rlVertex2f(bottom_left.x, bottom_left.y);
+    rlTexCoord2f(u1, v1);
+    rlVertex2f(bottom_right.x, bottom_right.y);
+    rlTexCoord2f(u1, v0);
+    rlVertex2f(top_right.x, top_right.y);
+}
+
+void SpriteBatch::end()
+{
+    rlEnd();
+    rlSetTexture(0);
+
+    // Submits the batch and goes back to raylib's default one
+    rlSetRenderBatchActive(nullptr);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <types.h>
+
+#include <raylib.h>
+#include <rlgl.h>
+#include <vector>
+
+// Draws sprites from several sprite sheets through one packed texture
+// atlas and a render batch of its own. Every quad between begin() and
+// end() lands in the same persistent vertex buffer and is submitted as
+// a single draw call, as long as the batch capacity isn't exceeded.
+//
+// Sprites keep pointing to their original sheet, the batch maps them to
+// their place in the atlas when drawing.
+class SpriteBatch
+{
+public:
+    struct Sheet
+    {
+        const Texture2D* texture;
+        Image image;
+    };
+
+    // Needs a window, the render batch lives on the GPU
+    explicit SpriteBatch(u32 max_quads = 16384);
+    ~SpriteBatch();
+
+    SpriteBatch(const SpriteBatch&) = delete;
+    SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+    // Packs the sheets into the atlas and uploads it. The images are only
+    // read, the caller still owns them.
+    void build_atlas(const std::vector<Sheet>& sheets);
+
+    void begin();
+    // Same arguments as DrawTexturePro, source is relative to the sheet
+    void draw(const Texture2D* sheet, Rectangle source, Rectangle dest, Vector2 origin, f32 rotation, Color tint);
+    void end();
+
+    [[nodiscard]] const Texture2D& get_atlas() const { return atlas; }
+
+private:
+    struct Region
+    {
+        const Texture2D* texture;
+        Vector2 offset;
+    };
+
+    [[nodiscard]] Vector2 find_offset(const Texture2D* sheet);
+
+    rlRenderBatch batch {};
+    Texture2D atlas {};
+    f32 inverse_atlas_width { 1.0f };
+    f32 inverse_atlas_height { 1.0f };
+
+    std::vector<Region> regions;
+    const Region* last_region { nullptr };
+};
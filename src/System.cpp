@@ -2,6 +2,7 @@
 #include <Util.h>
 
 #include <optional>
+#include <vector>
 
 namespace
 {
@@ -24,16 +25,18 @@ namespace
 
     void destroy_enemy(SystemContext& context, Entity enemy)
     {
+        // Already on its way out this frame
+        if (context.commands.is_removed(enemy)) return;
+
         auto& transform = enemy.get_component<Component::Transform>();
         for (u32 i = 0; i < 50; i++)
         {
             f32 spread = 20.0f;
             EffectType type = i % 2 == 0 ? EffectType::SMOKE : EffectType::EXPLOSION;
-            context.entity_manager.create_effect(context.assets.effects,
-                                                 type,
-                                                 transform.pos.x + Util::random_f32(-spread, spread),
-                                                 transform.pos.y + Util::random_f32(-spread, spread),
-                                                 Util::random_f32(1.0f, 6.0f));
+            context.particles.emit(type,
+                                   transform.pos.x + Util::random_f32(-spread, spread),
+                                   transform.pos.y + Util::random_f32(-spread, spread),
+                                   Util::random_f32(1.0f, 6.0f));
         }
 
         if (enemy.has_component<Component::Player>())
@@ -45,14 +48,28 @@ namespace
         {
             if(enemy.has_component<Component::Enemy>())
             {
-                context.entity_manager.create_pickup(context.assets.pickups, static_cast<PickupType>(Util::random_u8(0, 7)), transform.pos.x, transform.pos.y);
+                context.commands.create_pickup(context.assets.pickups, static_cast<PickupType>(Util::random_u8(0, 7)), transform.pos.x, transform.pos.y);
             }
             context.player.get_component<Component::Player>().score += 10;
-            context.sound_manager.play_die();
-            context.entity_manager.registry.destroy(enemy);
+            context.sound_manager.play_die(transform.pos);
+            if (enemy.has_component<Component::Projectile>())
+            {
+                context.commands.release_projectile(enemy);
+            }
+            else
+            {
+                context.commands.destroy(enemy);
+            }
         }
     }
 
+    // Destroyed, released back into the projectile pool, or about to be
+    bool is_gone(const SystemContext& context, entt::entity entity)
+    {
+        const auto& registry = context.entity_manager.registry;
+        return !registry.valid(entity) || registry.all_of<Component::Inactive>(entity) || context.commands.is_removed(entity);
+    }
+
     void damage_target(SystemContext& context, Entity target, u32 damage)
     {
         if (target.has_component<Component::Health>() && target.has_component<Component::Transform>())
@@ -77,150 +94,239 @@ namespace
     }
 }
 
-void System::update_stars(SystemContext& context, f32 dt)
-{
-    auto view = context.entity_manager.registry.view<Component::Transform, Component::Star>();
-    for (auto entity : view)
-    {
-        auto [transform, star] = view.get<Component::Transform, Component::Star>(entity);
-        if (star.growing)
-        {
-            if (transform.scale >= Component::Star::max_scale) star.growing = false;
-            else transform.scale += 0.01f * dt;
-        } else {
-            if (transform.scale <= Component::Star::min_scale) star.growing = true;
-            else transform.scale -= 0.01f * dt;
-        }
-    }
-}
-
 void System::update_enemies(SystemContext& context, f32 dt)
 {
     auto& player_transform = context.player.get_component<Component::Transform>();
     auto enemy_view = context.entity_manager.registry.view<Component::Transform, Component::Physics, Component::Enemy>();
+
+    auto& scratch = context.jobs.scratch();
+    const u32 capacity = static_cast<u32>(enemy_view.size_hint());
+    auto* entities = scratch.allocate<entt::entity>(capacity);
+    auto* thrusts = scratch.allocate<f32>(capacity);
+    auto* center_pull_randoms = scratch.allocate<f32>(capacity);
+    auto* shots = scratch.allocate<u8>(capacity);
+    // Rotation at the time of the shot, it changes further down
+    auto* shot_rotations = scratch.allocate<f32>(capacity);
+
+    // Random numbers are drawn up front, enemy by enemy in view order like
+    // the loop used to, the jobs below mustn't touch the generator
+    u32 count = 0;
     for (auto entity : enemy_view)
     {
-        auto [transform, physics, enemy] = enemy_view.get<Component::Transform, Component::Physics, Component::Enemy>(entity);
+        const auto& physics = enemy_view.get<Component::Physics>(entity);
 
         // Change the thrust randomly
-        static f32 thrust = physics.thrust;
-        static f32 thrust_timer = 0.0f;
-        thrust_timer += 1.0f * dt;
-        if (thrust_timer >= 1.0f)
+        auto& state = context.state;
+        if (!state.enemy_thrust) state.enemy_thrust = physics.thrust;
+        state.enemy_thrust_timer += 1.0f * dt;
+        if (state.enemy_thrust_timer >= 1.0f)
         {
-            thrust = Util::random_f32(physics.thrust - 20.0f, physics.thrust + 20.0f);
-            thrust_timer = 0.0f;
+            state.enemy_thrust = Util::random_f32(physics.thrust - 20.0f, physics.thrust + 20.0f);
+            state.enemy_thrust_timer = 0.0f;
         }
 
-        // Make enemies accelerate in the direction they are pointing
-        physics.acc.x += std::cos(transform.rotation) * thrust * dt;
-        physics.acc.y += std::sin(transform.rotation) * thrust * dt;
-
-        // Pull enemies toward center if too far away.
-        f32 angle_to_center = Util::get_angle_between_points(transform.pos, { 0.0f, 0.0f });
-        f32 distance = Util::distance_between_points(transform.pos, { 0.0f, 0.0f });
-        f32 center_pull_thrust = Util::lerp(Util::random_f32(0.0f, 0.01f), physics.thrust, distance / context.circle_radius);
-        physics.acc.x += std::cos(angle_to_center) * center_pull_thrust * dt;
-        physics.acc.y += std::sin(angle_to_center) * center_pull_thrust * dt;
-
-        // Rotate enemy towards player if within a certain looking radius
-        f32 target_rotation = std::atan2(player_transform.pos.y - transform.pos.y, player_transform.pos.x - transform.pos.x);
-        f32 rotation_diff = target_rotation - transform.rotation;
-
-        if (rotation_diff > PI) {
-            rotation_diff -= 2 * PI;
-        } else if (rotation_diff < -PI) {
-            rotation_diff += 2 * PI;
-        }
+        entities[count] = entity;
+        thrusts[count] = *state.enemy_thrust;
+        center_pull_randoms[count] = Util::random_f32(0.0f, 0.01f);
+        ++count;
+    }
 
-        // Shoot projectile when pointing towards and when in range of player
-        if (enemy.shoot_delay > 0) enemy.shoot_delay -= 1.0f * dt;
-        if (rotation_diff < PI / 8 && enemy.shoot_delay <= 0 && Util::distance_between_points(player_transform.pos, transform.pos) < 800)
+    context.jobs.parallel_for(count, 256, [&](u32 begin, u32 end)
+    {
+        for (u32 i = begin; i < end; ++i)
         {
-            for (u32 i = 0; i < enemy.multi_shot_amount; i++)
+            auto [transform, physics, enemy] = enemy_view.get<Component::Transform, Component::Physics, Component::Enemy>(entities[i]);
+
+            // Make enemies accelerate in the direction they are pointing
+            physics.acc.x += std::cos(transform.rotation) * thrusts[i] * dt;
+            physics.acc.y += std::sin(transform.rotation) * thrusts[i] * dt;
+
+            // Pull enemies toward center if too far away.
+            f32 angle_to_center = Util::get_angle_between_points(transform.pos, { 0.0f, 0.0f });
+            f32 distance = Util::distance_between_points(transform.pos, { 0.0f, 0.0f });
+            f32 center_pull_thrust = Util::lerp(center_pull_randoms[i], physics.thrust, distance / context.circle_radius);
+            physics.acc.x += std::cos(angle_to_center) * center_pull_thrust * dt;
+            physics.acc.y += std::sin(angle_to_center) * center_pull_thrust * dt;
+
+            // Rotate enemy towards player if within a certain looking radius
+            f32 target_rotation = std::atan2(player_transform.pos.y - transform.pos.y, player_transform.pos.x - transform.pos.x);
+            f32 rotation_diff = target_rotation - transform.rotation;
+
+            if (rotation_diff > PI) {
+                rotation_diff -= 2 * PI;
+            } else if (rotation_diff < -PI) {
+                rotation_diff += 2 * PI;
+            }
+
+            // Shoot projectile when pointing towards and when in range of player
+            shots[i] = 0;
+            if (enemy.shoot_delay > 0) enemy.shoot_delay -= 1.0f * dt;
+            if (rotation_diff < PI / 8 && enemy.shoot_delay <= 0 && Util::distance_between_points(player_transform.pos, transform.pos) < 800)
             {
-                context.sound_manager.play_shoot();
-                context.entity_manager.create_projectile(
-                        context.assets.projectiles,
-                        enemy.projectile_type,
-                        Entity(entity, &context.entity_manager.registry),
-                        transform.pos.x,
-                        transform.pos.y,
-                        transform.rotation);
+                shots[i] = 1;
+                shot_rotations[i] = transform.rotation;
+                enemy.shoot_delay = enemy.shoot_delay_max;
+            }
+
+            // Gradually update the enemy's rotation
+            transform.rotation += rotation_diff * enemy.rotation_speed * dt;
+
+            // Ensure the enemy's rotation is within the range of 0 to 2π
+            if (transform.rotation < 0) {
+                transform.rotation += 2 * PI;
+            } else if (transform.rotation >= 2 * PI) {
+                transform.rotation -= 2 * PI;
             }
-            enemy.shoot_delay = enemy.shoot_delay_max;
         }
+    });
 
-        // Gradually update the enemy's rotation
-        transform.rotation += rotation_diff * enemy.rotation_speed * dt;
+    // Shots are fired in view order
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (shots[i] == 0) continue;
 
-        // Ensure the enemy's rotation is within the range of 0 to 2π
-        if (transform.rotation < 0) {
-            transform.rotation += 2 * PI;
-        } else if (transform.rotation >= 2 * PI) {
-            transform.rotation -= 2 * PI;
+        const auto& transform = enemy_view.get<Component::Transform>(entities[i]);
+        const auto& enemy = enemy_view.get<Component::Enemy>(entities[i]);
+        for (u32 shot = 0; shot < enemy.multi_shot_amount; shot++)
+        {
+            context.sound_manager.play_shoot(transform.pos);
+            context.commands.create_projectile(
+                    context.assets.projectiles,
+                    enemy.projectile_type,
+                    Entity(entities[i], &context.entity_manager.registry),
+                    transform.pos.x,
+                    transform.pos.y,
+                    shot_rotations[i]);
         }
     }
 }
 
 void System::update_physics(SystemContext& context, f32 dt)
 {
-    auto view = context.entity_manager.registry.view<Component::Transform, Component::Physics>();
-    for (auto entity : view)
+    // Every job gets one storage page, chunks never straddle two of them
+    constexpr u32 page_size = entt::component_traits<Component::Transform>::page_size;
+    static_assert(page_size == entt::component_traits<Component::Physics>::page_size);
+    static_assert(page_size % PhysicsIntegrator::chunk_size == 0);
+
+    // The owning group keeps its bodies at the front of both storages, in the same order
+    auto group = context.entity_manager.moving_group();
+    auto** transform_pages = group.storage<Component::Transform>()->raw();
+    auto** physics_pages = group.storage<Component::Physics>()->raw();
+    const auto& integrator = context.integrator;
+
+    context.jobs.parallel_for(static_cast<u32>(group.size()), page_size, [&](u32 begin, u32 end)
     {
-        auto [transform, physics] = view.get<Component::Transform, Component::Physics>(entity);
+        auto& scratch = context.jobs.scratch();
+        constexpr u32 chunk_size = PhysicsIntegrator::chunk_size;
+        const PhysicsIntegrator::Bodies bodies {
+            scratch.allocate<f32>(chunk_size),
+            scratch.allocate<f32>(chunk_size),
+            scratch.allocate<f32>(chunk_size),
+            scratch.allocate<f32>(chunk_size),
+            scratch.allocate<f32>(chunk_size),
+            scratch.allocate<f32>(chunk_size),
+            scratch.allocate<f32>(chunk_size)
+        };
+
+        // Bodies are copied into the arrays a chunk at a time, integrated,
+        // and copied back while still in cache
+        for (u32 first = begin; first < end; first += chunk_size)
+        {
+            const u32 count = std::min(chunk_size, end - first);
+            auto* transform = transform_pages[first / page_size] + first % page_size;
+            auto* physics = physics_pages[first / page_size] + first % page_size;
+
+            for (u32 i = 0; i < count; ++i)
+            {
+                bodies.pos_x[i] = transform[i].pos.x;
+                bodies.pos_y[i] = transform[i].pos.y;
+                bodies.vel_x[i] = physics[i].vel.x;
+                bodies.vel_y[i] = physics[i].vel.y;
+                bodies.acc_x[i] = physics[i].acc.x;
+                bodies.acc_y[i] = physics[i].acc.y;
+                bodies.thrust[i] = physics[i].thrust;
+            }
+
+            integrator.integrate(bodies, count, dt);
+
+            for (u32 i = 0; i < count; ++i)
+            {
+                transform[i].pos = { bodies.pos_x[i], bodies.pos_y[i] };
+                physics[i].vel = { bodies.vel_x[i], bodies.vel_y[i] };
+                physics[i].acc = { bodies.acc_x[i], bodies.acc_y[i] };
+            }
+        }
+    });
+}
 
-        // Decay acceleration
-        physics.acc.x -= physics.acc.x * (1.0f - 0.001f) * dt;
-        physics.acc.y -= physics.acc.y * (1.0f - 0.001f) * dt;
+void System::update_enemy_index(SystemContext& context, f32 dt)
+{
+    context.enemy_index.clear();
 
-        // Update velocity based on acceleration
-        physics.vel.x += physics.acc.x * physics.thrust * dt;
-        physics.vel.y += physics.acc.y * physics.thrust * dt;
+    auto view = context.entity_manager.registry.view<Component::Transform, Component::Enemy>();
+    for (auto entity : view)
+    {
+        context.enemy_index.insert(entity, view.get<Component::Transform>(entity).pos, 0.0f);
+    }
 
-        // Decay velocity
-        physics.vel.x -= physics.vel.x * (1.0f - 0.001f) * dt;
-        physics.vel.y -= physics.vel.y * (1.0f - 0.001f) * dt;
+    context.enemy_index.build();
+}
 
-        // Update position based on velocity
-        transform.pos.x += physics.vel.x * dt;
-        transform.pos.y += physics.vel.y * dt;
+void System::update_broadphase(SystemContext& context, f32 dt)
+{
+    context.broadphase.clear();
 
-        // Cap velocity to a maximium
-        const float max_velocity = 200.0f;
-        float velocity_magnitude = sqrtf( physics.vel.x * physics.vel.x + physics.vel.y * physics.vel.y);
-        if (velocity_magnitude > max_velocity)
-        {
-            physics.vel.x = (physics.vel.x / velocity_magnitude) * max_velocity;
-            physics.vel.y = (physics.vel.y / velocity_magnitude) * max_velocity;
-        }
+    auto view = context.entity_manager.registry.view<Component::Transform, Component::CircleCollider>(entt::exclude<Component::Inactive>);
+    for (auto entity : view)
+    {
+        auto [transform, collider] = view.get<Component::Transform, Component::CircleCollider>(entity);
+        context.broadphase.insert(entity, transform.pos, collider.radius);
     }
+
+    context.broadphase.build();
 }
 
 void System::update_projectile_collisions(SystemContext& context, f32 dt)
 {
-    auto view = context.entity_manager.registry.view<Component::Transform, Component::CircleCollider, Component::Projectile>();
-    for (auto projectile_entity : view)
+    auto& registry = context.entity_manager.registry;
+    auto view = registry.view<Component::Transform, Component::CircleCollider, Component::Projectile>(entt::exclude<Component::Inactive>);
+
+    // Calls on_hit(entity) for everything the projectile overlaps and may
+    // hit, in broadphase order, until on_hit returns true
+    auto find_hits = [&](entt::entity projectile_entity, auto&& skip, auto&& on_hit)
     {
         auto [projectile_transform, projectile_collider, projectile] = view.get<Component::Transform, Component::CircleCollider, Component::Projectile>(projectile_entity);
 
-        auto other_view = context.entity_manager.registry.view<Component::Transform, Component::CircleCollider>();
-
-        for (auto entity : other_view)
+        bool done = false;
+        context.broadphase.query(projectile_transform.pos, projectile_collider.radius, [&](const SpatialHash::Entry& entry)
         {
-            auto game_entity = Entity(entity, &context.entity_manager.registry);
+            // Nothing moves between the broadphase and here, its entries have
+            // the position and radius the narrowphase would look up. Most
+            // candidates are out of reach and go before any component lookup.
+            if (Util::distance_between_points(projectile_transform.pos, entry.pos) >= projectile_collider.radius + entry.radius)
+            {
+                return;
+            }
+
+            if (done || skip(entry.entity))
+            {
+                // Already hit something, or the entry was removed earlier this frame
+                return;
+            }
+
+            auto game_entity = Entity(entry.entity, &registry);
 
             if (projectile_entity == game_entity)
             {
                 // Skip checking with itself
-                continue;
+                return;
             }
             else if (projectile.owner == game_entity ||
             (projectile.owner.has_component<Component::Enemy>() &&  game_entity.has_component<Component::Enemy>()))
             {
                 // Skip if hit with projectile's owner
                 // Or if enemy hit enemy
-                continue;
+                return;
             }
             else if (game_entity.has_component<Component::Projectile>())
             {
@@ -229,45 +335,108 @@ void System::update_projectile_collisions(SystemContext& context, f32 dt)
                 auto game_entity_projectile = view.get<Component::Projectile>(game_entity);
                 if (game_entity_projectile.owner == projectile.owner ||
                 (game_entity_projectile.owner.has_component<Component::Enemy>() && projectile.owner.has_component<Component::Enemy>())) {
-                    continue;
+                    return;
                 }
             } else if (game_entity.has_component<Component::Pickup>())
             {
                 // Skip hitting pickups
-                continue;
+                return;
             }
 
-            auto [transform, collider] = view.get<Component::Transform, Component::CircleCollider>(game_entity);
+            done = on_hit(game_entity);
+        });
+    };
+
+    // What is_gone() says without the command buffer, which can't change while the jobs run
+    auto is_dead = [&](entt::entity entity)
+    {
+        return !registry.valid(entity) || registry.all_of<Component::Inactive>(entity);
+    };
+
+    // Hits are looked up in parallel, ignoring whatever earlier projectiles
+    // destroy this tick. Projectiles are then handled in view order and a
+    // first hit that is gone by then is looked up again.
+    auto& scratch = context.jobs.scratch();
+    const u32 capacity = static_cast<u32>(view.size_hint());
+    auto* projectiles = scratch.allocate<entt::entity>(capacity);
+    auto* first_hits = scratch.allocate<entt::entity>(capacity);
+    auto* more_hits = scratch.allocate<u8>(capacity);
 
-            auto result = circle_intersect(projectile_transform, transform, projectile_collider, collider);
-            if (result.has_value()) {
-                Vector2 effect_spawn_point {
-                        projectile_transform.pos.x,
-                        projectile_transform.pos.y
-                };
+    u32 count = 0;
+    for (auto entity : view) projectiles[count++] = entity;
 
-                context.sound_manager.play_hit(projectile.type);
+    context.jobs.parallel_for(count, 64, [&](u32 begin, u32 end)
+    {
+        for (u32 i = begin; i < end; ++i)
+        {
+            first_hits[i] = entt::null;
+            more_hits[i] = 0;
+            find_hits(projectiles[i], is_dead, [&](entt::entity hit)
+            {
+                if (first_hits[i] != entt::null)
+                {
+                    more_hits[i] = 1;
+                    return true;
+                }
+                first_hits[i] = hit;
+                return false;
+            });
+        }
+    });
 
-                context.entity_manager.create_effect(context.assets.effects, EffectType::EXPLOSION, effect_spawn_point.x, effect_spawn_point.y);
-                context.entity_manager.registry.destroy(projectile_entity);
+    for (u32 i = 0; i < count; ++i)
+    {
+        const auto projectile_entity = projectiles[i];
 
-                // Can the "collided with entity" die?
-                damage_target(context, game_entity, projectile.damage);
+        // Hit by another projectile earlier in this loop
+        if (context.commands.is_removed(projectile_entity)) continue;
 
-                break;
+        entt::entity hit_entity = first_hits[i];
+        if (hit_entity != entt::null && context.commands.is_removed(hit_entity))
+        {
+            hit_entity = entt::null;
+            if (more_hits[i])
+            {
+                auto gone = [&](entt::entity entity) { return is_gone(context, entity); };
+                find_hits(projectile_entity, gone, [&](entt::entity hit)
+                {
+                    hit_entity = hit;
+                    return true;
+                });
             }
         }
+
+        if (hit_entity != entt::null)
+        {
+            auto [projectile_transform, projectile] = view.get<Component::Transform, Component::Projectile>(projectile_entity);
+            Vector2 effect_spawn_point {
+                    projectile_transform.pos.x,
+                    projectile_transform.pos.y
+            };
+            u32 damage = projectile.damage;
+
+            context.sound_manager.play_hit(projectile.type, effect_spawn_point);
+
+            context.particles.emit(EffectType::EXPLOSION, effect_spawn_point.x, effect_spawn_point.y);
+            context.commands.release_projectile(projectile_entity);
+
+            // Can the "collided with entity" die?
+            damage_target(context, Entity(hit_entity, &registry), damage);
+        }
     }
 }
 
 void System::update_projectiles(SystemContext& context, f32 dt)
 {
     auto& player_transform = context.player.get_component<Component::Transform>();
+    auto group = context.entity_manager.projectile_group();
 
-    auto view = context.entity_manager.registry.view<Component::Transform, Component::Physics, Component::Projectile>();
-    for (auto projectile_entity : view)
+    // Releasing changes what is_gone() says, it waits until the jobs are done
+    auto* released = context.jobs.scratch().allocate<u8>(group.size());
+
+    context.jobs.parallel_for_each(group, 256, [&](entt::entity projectile_entity, u32 index)
     {
-        auto [transform, physics, projectile] = view.get<Component::Transform, Component::Physics, Component::Projectile>(projectile_entity);
+        auto [projectile, transform, physics] = group.get<Component::Projectile, Component::Transform, Component::Physics>(projectile_entity);
 
         if (projectile.type == ProjectileType::HOMING)
         {
@@ -275,24 +444,21 @@ void System::update_projectiles(SystemContext& context, f32 dt)
 
             if (projectile.owner.has_component<Component::Player>())
             {
-                f32 shortest_distance = 99999.0;
-                entt::entity enemy = entt::null;
-                auto view_enemies = context.entity_manager.registry.view<Component::Transform, Component::Enemy>();
-                for (auto enemy_entity : view_enemies)
+                // Keep chasing the same enemy, look for the closest one again
+                // once in a while or when it died
+                projectile.retarget_timer -= dt;
+                if (projectile.target == entt::null || projectile.retarget_timer <= 0.0f || is_gone(context, projectile.target))
                 {
-                    auto [enemy_transform, enemy_component] = view_enemies.get<Component::Transform, Component::Enemy>(enemy_entity);
-                    f32 distance = Util::distance_between_points(enemy_transform.pos, transform.pos);
-                    if (distance < shortest_distance)
-                    {
-                        shortest_distance = distance;
-                        enemy = enemy_entity;
-                    }
+                    const auto* nearest = context.enemy_index.nearest(transform.pos, 99999.0f, [&](const SpatialHash::Entry& entry) {
+                        return !is_gone(context, entry.entity);
+                    });
+                    projectile.target = nearest != nullptr ? nearest->entity : entt::null;
+                    projectile.retarget_timer = Component::Projectile::RETARGET_INTERVAL;
                 }
 
-                if (enemy != entt::null)
+                if (projectile.target != entt::null)
                 {
-                    Entity enemy_game_entity = Entity(enemy, &context.entity_manager.registry);
-                    auto enemy_transform = enemy_game_entity.get_component<Component::Transform>();
+                    const auto& enemy_transform = context.entity_manager.registry.get<Component::Transform>(projectile.target);
                     f32 target_rotation = std::atan2(enemy_transform.pos.y - transform.pos.y, enemy_transform.pos.x - transform.pos.x);
                     rotation_diff = target_rotation - transform.rotation;
                 }
@@ -326,64 +492,60 @@ void System::update_projectiles(SystemContext& context, f32 dt)
         float dy = transform.pos.y - player_transform.pos.y;
         float distance = std::sqrt(dx * dx + dy * dy);
 
-        if (distance >= context.death_distance)
-        {
-            context.entity_manager.registry.destroy(projectile_entity);
-        }
+        released[index] = distance >= context.death_distance;
+    });
+
+    for (u32 i = 0; i < group.size(); ++i)
+    {
+        if (released[i]) context.commands.release_projectile(group[i]);
     }
 }
 
 void System::update_effects(SystemContext& context, f32 dt)
 {
-    auto view = context.entity_manager.registry.view<Component::Transform, Component::Effect, Component::Sprite>();
-    for (auto entity : view)
-    {
-        auto [transform, effect, sprite] = view.get<Component::Transform, Component::Effect, Component::Sprite>(entity);
-
-        effect.lifetime -= 5.0f * dt;
-
-        if (effect.lifetime <= 0.0f) {
-            context.entity_manager.registry.destroy(entity);
-            continue;
-        }
-
-        auto total_sprites_in_animation = sprite.texture->width / transform.size.x;
-        auto current_sprite = std::floor((1.0f - effect.lifetime) / 1.0f * total_sprites_in_animation);
-
-        sprite.offset_x = current_sprite * transform.size.x;
-        sprite.offset_y = static_cast<u32>(effect.type) * transform.size.y;
-
-    }
+    context.particles.update(dt);
 }
 
 void System::update_player_enemy_collisions(SystemContext& context, f32 dt)
 {
+    auto& registry = context.entity_manager.registry;
     auto& player_transform = context.player.get_component<Component::Transform>();
-    auto& player_physics = context.player.get_component<Component::Physics>();
     auto& player_collider = context.player.get_component<Component::CircleCollider>();
 
-    auto view = context.entity_manager.registry.view<Component::Transform, Component::Physics, Component::CircleCollider, Component::Enemy, Component::Health>();
-    for (auto enemy_entity : view)
+    // Collect first, destroying enemies below would invalidate the references
+    std::vector<entt::entity> hits;
+    context.broadphase.query(player_transform.pos, player_collider.radius, [&](const SpatialHash::Entry& entry)
     {
-        auto [transform, physics, collider, enemy, health] = view.get<Component::Transform, Component::Physics, Component::CircleCollider, Component::Enemy, Component::Health>(enemy_entity);
-
-        auto result = circle_intersect(player_transform, transform, player_collider, collider);
+        if (is_gone(context, entry.entity) ||
+            !registry.all_of<Component::Transform, Component::Physics, Component::CircleCollider, Component::Enemy, Component::Health>(entry.entity))
+        {
+            return;
+        }
 
-        if (result.has_value())
+        auto [transform, collider] = registry.get<Component::Transform, Component::CircleCollider>(entry.entity);
+        if (circle_intersect(player_transform, transform, player_collider, collider).has_value())
         {
-            damage_target(context, context.player, health.max_health + health.shield);
-            destroy_enemy(context, Entity(enemy_entity, &context.entity_manager.registry));
+            hits.push_back(entry.entity);
         }
+    });
+
+    for (auto enemy_entity : hits)
+    {
+        if (is_gone(context, enemy_entity)) continue;
+
+        auto& health = registry.get<Component::Health>(enemy_entity);
+        damage_target(context, context.player, health.max_health + health.shield);
+        destroy_enemy(context, Entity(enemy_entity, &registry));
     }
 }
 
 void System::update_health_circle_radius(SystemContext& context, f32 dt)
 {
-    static f32 damage_counter = 0.0f;
+    f32& damage_counter = context.state.circle_damage_counter;
     damage_counter += 5.0f * dt;
     damage_counter = std::min(damage_counter, 1.0f);
 
-    auto view = context.entity_manager.registry.view<Component::Transform, Component::Health>();
+    auto view = context.entity_manager.registry.view<Component::Transform, Component::Health>(entt::exclude<Component::Inactive>);
     for (auto entity : view)
     {
         auto [transform, health] = view.get<Component::Transform, Component::Health>(entity);
@@ -446,60 +608,71 @@ void System::update_player_pickup_collisions(SystemContext& context, f32 dt)
     auto& player_component = context.player.get_component<Component::Player>();
     auto& player_health = context.player.get_component<Component::Health>();
 
-    auto view = context.entity_manager.registry.view<Component::Transform, Component::CircleCollider, Component::Pickup>();
-    for (auto entity : view)
+    auto& registry = context.entity_manager.registry;
+
+    std::vector<entt::entity> hits;
+    context.broadphase.query(player_transform.pos, player_collider.radius, [&](const SpatialHash::Entry& entry)
     {
-        auto [transform, collider, pickup] = view.get<Component::Transform, Component::CircleCollider, Component::Pickup>(entity);
+        if (is_gone(context, entry.entity) || !registry.all_of<Component::Transform, Component::Pickup>(entry.entity))
+        {
+            return;
+        }
 
-        auto result = circle_intersect(player_transform, transform, player_collider, collider);
-        if (result.has_value())
+        auto [transform, collider] = registry.get<Component::Transform, Component::CircleCollider>(entry.entity);
+        if (circle_intersect(player_transform, transform, player_collider, collider).has_value())
         {
-            context.entity_manager.registry.destroy(entity);
+            hits.push_back(entry.entity);
+        }
+    });
+
+    for (auto entity : hits)
+    {
+        auto pickup = registry.get<Component::Pickup>(entity);
+        context.commands.destroy(entity);
 
-            switch(pickup.type)
+        switch(pickup.type)
+        {
+            case PickupType::COINS:
             {
-                case PickupType::COINS:
-                {
-                    player_component.score += pickup.pickup_amount;
-                    break;
-                }
-                case PickupType::HEALTH:
-                {
-                    player_health.health += pickup.pickup_amount;
-                    player_health.health = std::min (player_health.health, player_health.max_health);
-                    break;
-                }
-                case PickupType::SHIELD:
-                {
-                    player_health.shield += pickup.pickup_amount;
-                    player_health.shield = std::min (player_health.shield, player_health.max_shield);
-                    break;
-                }
-                case PickupType::SHELL:
-                {
-                    player_component.shell_amount += pickup.pickup_amount;
-                    break;
-                }
-                case PickupType::ROCKET:
-                {
-                    player_component.rocket_amount += pickup.pickup_amount;
-                    break;
-                }
-                case PickupType::HOMING:
-                {
-                    player_component.homing_amount += pickup.pickup_amount;
-                    break;
-                }
-                case PickupType::SHOT_UPGRADE:
-                {
-                    player_component.multi_shot_amount += 1;
-                    break;
-                }
-                case PickupType::ENGINE_UPGRADE:
-                {
-                    player_physics.thrust += 25.0f;
-                    break;
-                }
+                player_component.score += pickup.pickup_amount;
+                break;
+            }
+            case PickupType::HEALTH:
+            {
+                player_health.health += pickup.pickup_amount;
+                player_health.health = std::min (player_health.health, player_health.max_health);
+                break;
+            }
+            case PickupType::SHIELD:
+            {
+                player_health.shield += pickup.pickup_amount;
+                player_health.shield = std::min (player_health.shield, player_health.max_shield);
+                break;
+            }
+            case PickupType::SHELL:
+            {
+                player_component.shell_amount += pickup.pickup_amount;
+                break;
+            }
+            case PickupType::ROCKET:
+            {
+                player_component.rocket_amount += pickup.pickup_amount;
+                break;
+            }
+            case PickupType::HOMING:
+            {
+                player_component.homing_amount += pickup.pickup_amount;
+                break;
+            }
+            case PickupType::SHOT_UPGRADE:
+            {
+                player_component.multi_shot_amount += 1;
+                break;
+            }
+            case PickupType::ENGINE_UPGRADE:
+            {
+                player_physics.thrust += 25.0f;
+                break;
             }
         }
     }
@@ -5,25 +5,55 @@
 #include <Entity.h>
 #include <EntityManager.h>
 #include <Assets.h>
+#include <SpatialHash.h>
+#include <ParticleSystem.h>
+#include <CommandBuffer.h>
+#include <PhysicsIntegrator.h>
+#include <JobSystem.h>
 #include "SoundManager.h"
 
+#include <optional>
+
+// What the systems carry over from one tick to the next outside the registry.
+// It lives as long as the simulation, levels don't reset it.
+struct SystemState
+{
+    // Thrust of every enemy, picked anew each second, the first enemy's until then
+    std::optional<f32> enemy_thrust {};
+    f32 enemy_thrust_timer { 0.0f };
+    // Entities outside the circle take damage five times a second
+    f32 circle_damage_counter { 0.0f };
+};
+
 struct SystemContext
 {
     Entity player;
     EntityManager& entity_manager;
     SoundManager& sound_manager;
+    SpatialHash& broadphase;
+    // Enemy positions as of the start of the tick, for target searches
+    SpatialHash& enemy_index;
+    ParticleSystem& particles;
+    PhysicsIntegrator& integrator;
+    // Systems split their entities across threads with this, side effects
+    // are applied afterwards in entity order. Scratch memory lasts for the tick.
+    JobSystem& jobs;
+    // Creating, destroying and releasing entities goes through here
+    CommandBuffer& commands;
     Assets& assets;
     f32 circle_radius;
     f32 death_distance;
     bool& game_over;
+    SystemState& state;
 };
 
 namespace System
 {
     void update_pickups(SystemContext& context, f32 dt);
-    void update_stars(SystemContext& context, f32 dt);
     void update_enemies(SystemContext& context, f32 dt);
     void update_physics(SystemContext& context, f32 dt);
+    void update_broadphase(SystemContext& context, f32 dt);
+    void update_enemy_index(SystemContext& context, f32 dt);
     void update_projectiles(SystemContext& context, f32 dt);
     void update_effects(SystemContext& context, f32 dt);
     void update_player_enemy_collisions(SystemContext& context, f32 dt);
@@ -0,0 +1,128 @@
+#include <SystemScheduler.h>
+
+#include <chrono>
+
+namespace
+{
+    entt::id_type resource_id(Resource resource)
+    {
+        switch (resource)
+        {
+            case Resource::RANDOM:      return entt::hashed_string::value("resource/random");
+            case Resource::SOUND:       return entt::hashed_string::value("resource/sound");
+            case Resource::PARTICLES:   return entt::hashed_string::value("resource/particles");
+            case Resource::COMMANDS:    return entt::hashed_string::value("resource/commands");
+            case Resource::BROADPHASE:  return entt::hashed_string::value("resource/broadphase");
+            case Resource::ENEMY_INDEX: return entt::hashed_string::value("resource/enemy_index");
+            case Resource::INTEGRATOR:  return entt::hashed_string::value("resource/integrator");
+            case Resource::GAME_STATE:  return entt::hashed_string::value("resource/game_state");
+        }
+        return entt::hashed_string::value("resource/unknown");
+    }
+}
+
+SystemScheduler::SystemScheduler(JobSystem& jobs)
+    : jobs(jobs)
+{
+}
+
+SystemScheduler& SystemScheduler::add(const char* name, SystemFunc system)
+{
+    flow.bind(static_cast<entt::id_type>(tasks.size()));
+    tasks.push_back(Task { name, system });
+    graph_dirty = true;
+    return *this;
+}
+
+SystemScheduler& SystemScheduler::sync()
+{
+    flow.sync();
+    tasks.back().uses_random = true;
+    return *this;
+}
+
+SystemScheduler& SystemScheduler::reads(Resource resource)
+{
+    flow.ro(resource_id(resource));
+    return *this;
+}
+
+SystemScheduler& SystemScheduler::writes(Resource resource)
+{
+    flow.rw(resource_id(resource));
+    tasks.back().uses_random |= resource == Resource::RANDOM;
+    return *this;
+}
+
+void SystemScheduler::build_graph()
+{
+    // Tasks are bound with their index as id, vertices come out in the same order
+    const auto graph = flow.graph();
+
+    for (auto& task : tasks)
+    {
+        task.successors.clear();
+        task.predecessor_count = 0;
+    }
+
+    for (auto [from, to] : graph.edges())
+    {
+        tasks[from].successors.push_back(static_cast<u32>(to));
+        tasks[to].predecessor_count += 1;
+    }
+
+    pending = std::make_unique<std::atomic<u32>[]>(tasks.size());
+    graph_dirty = false;
+}
+
+void SystemScheduler::run(SystemContext& context, f32 dt, Profiler& profiler)
+{
+    if (tasks.empty()) return;
+    if (graph_dirty) build_graph();
+
+    this->context = &context;
+    this->dt = dt;
+    random = Random::engine();
+
+    for (u32 i = 0; i < tasks.size(); ++i)
+    {
+        pending[i].store(tasks[i].predecessor_count, std::memory_order_relaxed);
+    }
+    for (u32 i = 0; i < tasks.size(); ++i)
+    {
+        if (tasks[i].predecessor_count == 0) jobs.submit(counter, execute, this, i);
+    }
+    jobs.wait(counter);
+
+    Random::engine() = random;
+
+    for (const auto& task : tasks)
+    {
+        profiler.record(task.name, task.ms);
+    }
+}
+
+void SystemScheduler::execute(void* data, u32 index, u32)
+{
+    auto& scheduler = *static_cast<SystemScheduler*>(data);
+    auto& task = scheduler.tasks[index];
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Only one task using the generator runs at a time, they are ordered like any other writers
+    if (task.uses_random) Random::engine() = scheduler.random;
+    task.system(*scheduler.context, scheduler.dt);
+    if (task.uses_random) scheduler.random = Random::engine();
+
+    const auto end = std::chrono::steady_clock::now();
+    task.ms = std::chrono::duration<f64, std::milli>(end - start).count();
+
+    // Queued before this job counts as done, so the counter can't run out in between
+    for (u32 successor : task.successors)
+    {
+        if (scheduler.pending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            scheduler.jobs.submit(scheduler.counter, execute, data, successor);
+        }
+    }
+}
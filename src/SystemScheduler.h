@@ -0,0 +1,101 @@
+#pragma once
+
+#include <types.h>
+#include <System.h>
+#include <JobSystem.h>
+#include <Profiler.h>
+#include <Random.h>
+
+#include <entt/entt.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// State shared by systems that isn't a component
+enum class Resource : u8
+{
+    RANDOM = 0,
+    SOUND,
+    PARTICLES,
+    COMMANDS,
+    BROADPHASE,
+    ENEMY_INDEX,
+    INTEGRATOR,
+    // game_over and whatever else Simulation hands out by reference
+    GAME_STATE
+};
+
+// Runs systems as a task graph. Every system declares the components and
+// resources it reads and writes, systems that touch the same thing and at
+// least one of them writes it run in the order they were added, everything
+// else may run at the same time as jobs. Sync points wait
+// for everything added before them and everything added after waits for them.
+//
+// Systems drawing random numbers have to write Resource::RANDOM, they get
+// the calling thread's generator handed over so seeded runs stay reproducible
+// no matter which thread ends up running them.
+class SystemScheduler
+{
+public:
+    using SystemFunc = void (*)(SystemContext&, f32);
+
+    explicit SystemScheduler(JobSystem& jobs);
+
+    SystemScheduler(const SystemScheduler&) = delete;
+    SystemScheduler& operator=(const SystemScheduler&) = delete;
+
+    // The access calls that follow apply to this system
+    SystemScheduler& add(const char* name, SystemFunc system);
+    // Turns the last added system into a sync point, it has access to everything
+    SystemScheduler& sync();
+
+    template<typename... Components>
+    SystemScheduler& reads()
+    {
+        (flow.ro(entt::type_hash<Components>::value()), ...);
+        return *this;
+    }
+
+    template<typename... Components>
+    SystemScheduler& writes()
+    {
+        (flow.rw(entt::type_hash<Components>::value()), ...);
+        return *this;
+    }
+
+    SystemScheduler& reads(Resource resource);
+    SystemScheduler& writes(Resource resource);
+
+    // Runs every system once and returns when all of them finished, system
+    // times are recorded into the profiler afterwards from this thread.
+    // Has to be called from the thread that created the job system.
+    void run(SystemContext& context, f32 dt, Profiler& profiler);
+
+private:
+    struct Task
+    {
+        const char* name;
+        SystemFunc system;
+        bool uses_random { false };
+        std::vector<u32> successors {};
+        u32 predecessor_count { 0 };
+        // Includes other systems the thread ran while waiting for this one's jobs
+        f64 ms { 0.0 };
+    };
+
+    void build_graph();
+    // Job entry point, runs the task and queues the successors it was the last one waiting for
+    static void execute(void* data, u32 index, u32);
+
+    JobSystem& jobs;
+    entt::flow flow {};
+    std::vector<Task> tasks {};
+    bool graph_dirty { true };
+
+    // Per tick state
+    JobCounter counter {};
+    std::unique_ptr<std::atomic<u32>[]> pending {};
+    SystemContext* context { nullptr };
+    f32 dt { 0.0f };
+    Random::Pcg32 random {};
+};
@@ -4,26 +4,19 @@
 
 u32 Util::random_u32(u32 min, u32 max)
 {
-    std::random_device rd {};
-    std::mt19937 rng(rd());
-    std::uniform_int_distribution<u32> dist(min, max);
-    return dist(rng);
+    u32 range = max - min + 1;
+    if (range == 0) return Random::engine().next();
+    return min + Random::engine().next_bounded(range);
 }
 
 u8 Util::random_u8(u8 min, u8 max)
 {
-    std::random_device rd {};
-    std::mt19937 rng(rd());
-    std::uniform_int_distribution<u8> dist(min, max);
-    return dist(rng);
+    return static_cast<u8>(random_u32(min, max));
 }
 
 f32 Util::random_f32(f32 min, f32 max)
 {
-    std::random_device rd {};
-    std::mt19937 rng(rd());
-    std::uniform_real_distribution<f32> dist(min, max);
-    return dist(rng);
+    return min + (max - min) * Random::engine().next_f32();
 }
 
 f32 Util::lerp(f32 a, f32 b, f32 t)
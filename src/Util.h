@@ -1,9 +1,9 @@
 #pragma once
 
 #include <types.h>
+#include <Random.h>
 
 #include <raylib.h>
-#include <random>
 #include <vector>
 #include <algorithm>
 
@@ -29,9 +29,6 @@ namespace Util
 
     template <typename T>
     void shuffle_vector(std::vector<T>& vec) {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-
-        std::shuffle(vec.begin(), vec.end(), gen);
+        std::shuffle(vec.begin(), vec.end(), Random::engine());
     }
 }
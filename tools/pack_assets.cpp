@@ -0,0 +1,79 @@
+#include <AssetArchive.h>
+#include <Loader.h>
+
+#include <raylib.h>
+#include <iostream>
+#include <string>
+
+// Build step, decodes the game's assets once and writes them into a single
+// archive the game maps at startup. Assets are stored under the path they
+// are given as, relative to where the game runs from.
+//
+// Usage: AstralindaPack OUTPUT FILE...
+//        .png files become RGBA8 images, .ogg and .wav files PCM waves and
+//        .json files the compiled level table.
+
+namespace
+{
+    bool ends_with(const std::string& text, const std::string& suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    bool pack(AssetArchiveWriter& writer, const std::string& file)
+    {
+        if (ends_with(file, ".png"))
+        {
+            Image image = LoadImage(file.c_str());
+            if (image.data == nullptr) return false;
+            ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            const bool added = writer.add_image(file, image);
+            UnloadImage(image);
+            return added;
+        }
+        if (ends_with(file, ".ogg") || ends_with(file, ".wav"))
+        {
+            Wave wave = LoadWave(file.c_str());
+            const bool added = writer.add_wave(file, wave);
+            UnloadWave(wave);
+            return added;
+        }
+        if (ends_with(file, ".json"))
+        {
+            const auto levels = Loader::load_levels(file);
+            return levels.has_value() && writer.add_levels(file, levels.value());
+        }
+
+        std::cerr << "Don't know how to pack '" << file << "'\n";
+        return false;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: AstralindaPack OUTPUT FILE...\n";
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    AssetArchiveWriter writer;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (!pack(writer, argv[i]))
+        {
+            std::cerr << "Unable to pack '" << argv[i] << "'\n";
+            return 1;
+        }
+    }
+
+    if (!writer.write(argv[1]))
+    {
+        std::cerr << "Unable to write '" << argv[1] << "'\n";
+        return 1;
+    }
+
+    return 0;
+}